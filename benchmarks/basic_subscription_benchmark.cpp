@@ -0,0 +1,140 @@
+#include "benchmark.h"
+
+#include "subscriptions/BasicSubscription.h"
+#include "subscriptions/BehaviorSubscription.h"
+#include "subscriptions/ReplaySubscription.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace subscriptions;
+
+constexpr size_t kSubscriberCount = 1000;
+
+template <class Policy>
+const char* policyName();
+
+template <>
+const char* policyName<SingleThreaded>() { return "single thread"; }
+template <>
+const char* policyName<MultiThreaded>() { return "multi thread"; }
+template <>
+const char* policyName<VectorStorage>() { return "vector"; }
+template <>
+const char* policyName<SlotMapStorage>() { return "slot map"; }
+template <>
+const char* policyName<InlineStorage<4>>() { return "inline"; }
+template <>
+const char* policyName<Ordered>() { return "ordered"; }
+template <>
+const char* policyName<Unordered>() { return "unordered"; }
+
+template <class Threading, class Storage, class Ordering>
+void measureCombination()
+{
+    const std::string prefix = std::string(policyName<Threading>()) + ", " +
+                               policyName<Storage>() + ", " + policyName<Ordering>() + ": ";
+
+    BasicSubscription<void(int), Threading, Storage, Ordering> subscription;
+    long sum = 0;
+    std::vector<Disposable> disposables(kSubscriberCount);
+    for (auto& disposable : disposables)
+        disposable = subscription.subscribe([&sum](int value) { sum += value; });
+
+    benchmarks::measure((prefix + "notify 1k").c_str(), 10000, [&] { subscription.notifyAll(1); });
+
+    // Handles are replaced in a stride, so removal happens all over the storage
+    size_t index = 0;
+    benchmarks::measure((prefix + "dispose and subscribe in 1k").c_str(), 100000, [&] {
+        index = (index + 397) % kSubscriberCount;
+        disposables[index] = subscription.subscribe([&sum](int value) { sum -= value; });
+    });
+
+    // A callback replaces a tenth of handles during every notification
+    auto churn = subscription.subscribe([&](int) {
+        for (size_t i = 0; i < kSubscriberCount / 10; ++i) {
+            index = (index + 397) % kSubscriberCount;
+            disposables[index] = subscription.subscribe([&sum](int value) { sum += value; });
+        }
+    });
+    benchmarks::measure((prefix + "notify 1k replacing 100").c_str(), 10000, [&] {
+        subscription.notifyAll(1);
+    });
+}
+
+template <class Threading, class Storage>
+void measureOrderings()
+{
+    measureCombination<Threading, Storage, Ordered>();
+    measureCombination<Threading, Storage, Unordered>();
+}
+
+template <class Threading>
+void measureStorages()
+{
+    measureOrderings<Threading, VectorStorage>();
+    measureOrderings<Threading, SlotMapStorage>();
+    measureOrderings<Threading, InlineStorage<4>>();
+}
+
+void measureVoting()
+{
+    std::vector<Disposable> disposables;
+    BasicSubscription<bool(int)> voters;
+    BasicSubscription<void(int)> accumulating;
+    bool allowed = true;
+    for (size_t i = 0; i < kSubscriberCount; ++i) {
+        disposables.push_back(voters.subscribe([](int route) { return route >= 0; }));
+        disposables.push_back(accumulating.subscribe([&allowed](int route) {
+            allowed = allowed && route >= 0;
+        }));
+    }
+    benchmarks::measure("BasicSubscription: 1k votes, captured accumulator", 10000, [&] {
+        allowed = true;
+        accumulating.notifyAll(1);
+    });
+    benchmarks::measure("BasicSubscription: 1k votes, AllOf combiner", 10000, [&] {
+        allowed = voters.notifyAll(AllOf(), 1);
+    });
+}
+
+void measureBehavior()
+{
+    BehaviorSubscription<int> subscription(0);
+    int sum = 0;
+    auto keeper = subscription.subscribe([&sum](int value) { sum += value; });
+    benchmarks::measure("BehaviorSubscription: subscribe with the value and notify", 1000000, [&] {
+        auto disposable = subscription.subscribe([&sum](int value) { sum += value; });
+        subscription.notifyAll(sum & 1);
+    });
+}
+
+void measureReplay()
+{
+    ReplaySubscription<int> subscription(100);
+    int sum = 0;
+    auto keeper = subscription.subscribe([&sum](int value) { sum += value; });
+    benchmarks::measure("ReplaySubscription: notify into 100 slots", 1000000, [&] {
+        subscription.notifyAll(sum & 1);
+    });
+    benchmarks::measure("ReplaySubscription: subscribe replaying 100 events", 100000, [&] {
+        auto disposable = subscription.subscribe([&sum](int value) { sum += value; });
+    });
+}
+
+}  // namespace
+
+namespace benchmarks {
+
+void basicSubscription()
+{
+    measureStorages<SingleThreaded>();
+    measureStorages<MultiThreaded>();
+    measureVoting();
+    measureBehavior();
+    measureReplay();
+}
+
+}  // namespace benchmarks
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+namespace benchmarks {
+
+// Forces the compiler to assume memory is read and written, so results of calls are not folded
+inline void clobberMemory()
+{
+    asm volatile("" : : : "memory");
+}
+
+// Prints average time of one call of func
+template <class Func>
+void measure(const char* name, size_t iterations, Func&& func)
+{
+    func();  // warm up
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        func();
+        clobberMemory();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const double ns = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    std::printf("%-60s %12.1f ns\n", name, ns);
+}
+
+void basicSubscription();
+
+void classicSubscription();
+
+void lambdaSubscription();
+
+}  // namespace benchmarks
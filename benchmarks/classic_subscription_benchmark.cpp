@@ -0,0 +1,91 @@
+#include "benchmark.h"
+
+#include "subscriptions/ClassicSubscription.h"
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct IListener {
+    virtual ~IListener() = default;
+
+    virtual void onChanged(int value) = 0;
+};
+
+template <int Kind>
+struct Listener final : IListener {
+    void onChanged(int value) override { sum += value * Kind; }
+
+    long sum = 0;
+};
+
+using Listener1 = Listener<1>;
+using Listener2 = Listener<2>;
+using Listener3 = Listener<3>;
+using Listener4 = Listener<4>;
+
+constexpr size_t kListenerCount = 10000;
+
+// Listeners of four types interleaved, so consecutive calls go to different targets
+struct MixedListeners {
+    MixedListeners()
+    {
+        for (size_t i = 0; i < kListenerCount; ++i) {
+            switch (i % 4) {
+                case 0: listeners.push_back(std::make_unique<Listener1>()); break;
+                case 1: listeners.push_back(std::make_unique<Listener2>()); break;
+                case 2: listeners.push_back(std::make_unique<Listener3>()); break;
+                default: listeners.push_back(std::make_unique<Listener4>()); break;
+            }
+        }
+    }
+
+    template <class Subscription>
+    std::vector<subscriptions::Disposable> subscribe(Subscription& subscription)
+    {
+        std::vector<subscriptions::Disposable> disposables;
+        for (size_t i = 0; i < listeners.size(); ++i) {
+            IListener* listener = listeners[i].get();
+            switch (i % 4) {
+                case 0: disposables.push_back(subscription.subscribe(static_cast<Listener1*>(listener))); break;
+                case 1: disposables.push_back(subscription.subscribe(static_cast<Listener2*>(listener))); break;
+                case 2: disposables.push_back(subscription.subscribe(static_cast<Listener3*>(listener))); break;
+                default: disposables.push_back(subscription.subscribe(static_cast<Listener4*>(listener))); break;
+            }
+        }
+        return disposables;
+    }
+
+    std::vector<std::unique_ptr<IListener>> listeners;
+};
+
+}  // namespace
+
+namespace benchmarks {
+
+void classicSubscription()
+{
+    using namespace subscriptions;
+
+    MixedListeners mixed;
+    {
+        ClassicSubscription<IListener> subscription;
+        auto disposables = mixed.subscribe(subscription);
+        measure("ClassicSubscription: 10k mixed listeners, virtual dispatch", 1000, [&] {
+            subscription.notifyAll(&IListener::onChanged, 1);
+        });
+    }
+    {
+        ClassicSubscription<IListener, Listener1, Listener2, Listener3, Listener4> subscription;
+        auto disposables = mixed.subscribe(subscription);
+        measure("ClassicSubscription: 10k mixed listeners, grouped by type", 1000, [&] {
+            subscription.notifyAll(&IListener::onChanged, 1);
+        });
+        measure("ClassicSubscription: 10k mixed listeners, grouped by type, notifyEach", 1000, [&] {
+            subscription.notifyEach(&IListener::onChanged, [](auto* listener) { listener->onChanged(1); });
+        });
+    }
+}
+
+}  // namespace benchmarks
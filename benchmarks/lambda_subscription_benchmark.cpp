@@ -0,0 +1,209 @@
+#include "benchmark.h"
+
+#include "subscriptions/BucketedLambdaSubscription.h"
+#include "subscriptions/LambdaSubscription.h"
+#include "subscriptions/StaticSubscription.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct Observer {
+    void onPropertyChanged() { ++count; }
+
+    long count = 0;
+};
+
+constexpr size_t kObserverCount = 10000;
+
+template <class Subscription>
+void notifyWeakObservers(const char* name)
+{
+    using namespace subscriptions;
+
+    std::vector<std::shared_ptr<Observer>> observers;
+    std::vector<Disposable> disposables;
+    Subscription subscription;
+    for (size_t i = 0; i < kObserverCount; ++i) {
+        auto observer = std::make_shared<Observer>();
+        disposables.push_back(
+            subscription.subscribe([weak_observer = std::weak_ptr<Observer>(observer)]() {
+                if (auto lock = weak_observer.lock())
+                    lock->onPropertyChanged();
+            }));
+        observers.push_back(std::move(observer));
+    }
+    benchmarks::measure(name, 1000, [&] { subscription.notifyAll(); });
+}
+
+struct TrackableObserver : subscriptions::Trackable {
+    void onPropertyChanged() { ++count; }
+
+    long count = 0;
+};
+
+void notifyTrackableObservers(const char* name)
+{
+    using namespace subscriptions;
+
+    std::vector<TrackableObserver> observers(kObserverCount);
+    LambdaSubscription subscription;
+    for (auto& observer : observers)
+        subscription.subscribe<&TrackableObserver::onPropertyChanged>(observer);
+    benchmarks::measure(name, 1000, [&] { subscription.notifyAll(); });
+}
+
+void connectAndDisconnectTrackableObservers(const char* name)
+{
+    using namespace subscriptions;
+
+    LambdaSubscription subscription;
+    benchmarks::measure(name, 100, [&] {
+        {
+            std::vector<TrackableObserver> observers(kObserverCount);
+            for (auto& observer : observers)
+                subscription.subscribe<&TrackableObserver::onPropertyChanged>(observer);
+        }
+        subscription.notifyAll();
+    });
+}
+
+template <class Threading>
+void subscribeAndDispose(const char* name)
+{
+    using namespace subscriptions;
+
+    BasicLambdaSubscription<Threading> subscription;
+    Observer observer;
+    auto keeper = subscription.template subscribe<&Observer::onPropertyChanged>(&observer);
+    benchmarks::measure(name, 1000000, [&] {
+        auto disposable = subscription.template subscribe<&Observer::onPropertyChanged>(&observer);
+        subscription.notifyAll();
+    });
+}
+
+}  // namespace
+
+namespace benchmarks {
+
+void lambdaSubscription()
+{
+    using namespace subscriptions;
+
+    {
+        LambdaSubscription subscription;
+        Observer observer;
+        auto disposable = subscription.subscribe<&Observer::onPropertyChanged>(&observer);
+        measure("LambdaSubscription: single subscriber", 1000000, [&] { subscription.notifyAll(); });
+    }
+    {
+        Observer observers[4];
+        LambdaSubscription subscription;
+        std::vector<Disposable> disposables;
+        for (auto& observer : observers)
+            disposables.push_back(subscription.subscribe<&Observer::onPropertyChanged>(&observer));
+        measure("LambdaSubscription: 4 subscribers", 1000000, [&] { subscription.notifyAll(); });
+
+        StaticSubscription staticSubscription(
+            [&] { observers[0].onPropertyChanged(); },
+            [&] { observers[1].onPropertyChanged(); },
+            [&] { observers[2].onPropertyChanged(); },
+            [&] { observers[3].onPropertyChanged(); });
+        measure("StaticSubscription: 4 subscribers", 1000000, [&] { staticSubscription.notifyAll(); });
+    }
+    {
+        std::vector<Observer> observers(kObserverCount);
+        LambdaSubscription subscription;
+        std::vector<Disposable> disposables;
+        for (auto& observer : observers)
+            disposables.push_back(subscription.subscribe<&Observer::onPropertyChanged>(&observer));
+        measure("LambdaSubscription: 10k member callbacks", 1000, [&] { subscription.notifyAll(); });
+        subscription.freeze();
+        measure("LambdaSubscription: 10k member callbacks, frozen", 1000, [&] {
+            subscription.notifyAll();
+        });
+    }
+    subscribeAndDispose<SingleThreaded>("LambdaSubscription: subscribe+dispose, single thread");
+    subscribeAndDispose<MultiThreaded>("LambdaSubscription: subscribe+dispose, multi thread");
+    {
+        std::vector<Observer> observers(100);
+        LambdaSubscription subscription;
+        std::vector<Disposable> disposables;
+        for (auto& observer : observers)
+            disposables.push_back(subscription.subscribe<&Observer::onPropertyChanged>(&observer));
+        Observer observer;
+        Disposable disposable;
+        measure("LambdaSubscription: dispose itself in 100", 100000, [&] {
+            disposable = subscription.subscribe([&] {
+                observer.onPropertyChanged();
+                disposable.dispose();
+            });
+            subscription.notifyAll();
+        });
+        measure("LambdaSubscription: return false in 100", 100000, [&] {
+            disposable = subscription.subscribe([&] {
+                observer.onPropertyChanged();
+                return false;
+            });
+            subscription.notifyAll();
+        });
+        measure("LambdaSubscription: subscribeOnce in 100", 100000, [&] {
+            disposable = subscription.subscribeOnce([&] { observer.onPropertyChanged(); });
+            subscription.notifyAll();
+        });
+    }
+    {
+        Observer observer;
+        LambdaSubscription subscription;
+        measure("LambdaSubscription: subscribe and dispose 1k one by one", 100, [&] {
+            std::vector<Disposable> disposables;
+            disposables.reserve(1000);
+            for (int i = 0; i < 1000; ++i)
+                disposables.push_back(subscription.subscribe<&Observer::onPropertyChanged>(&observer));
+        });
+        measure("LambdaSubscription: subscribe and dispose 1k composite", 100, [&] {
+            CompositeDisposable disposables;
+            disposables.reserve(1000);
+            for (int i = 0; i < 1000; ++i)
+                disposables += subscription.subscribe<&Observer::onPropertyChanged>(&observer);
+        });
+        std::vector<std::function<void()>> callbacks(1000, [&observer] { observer.onPropertyChanged(); });
+        measure("LambdaSubscription: subscribeMany and disposeMany 1k", 100, [&] {
+            auto disposables = subscription.subscribeMany(callbacks);
+            disposeMany(disposables);
+        });
+    }
+    {
+        // Only the first of 1k handlers is interested in the event
+        LambdaSubscription subscription;
+        std::vector<Disposable> disposables;
+        bool handled = false;
+        disposables.push_back(subscription.subscribe([&handled] {
+            handled = true;
+            return Propagation::Stop;
+        }, 1));
+        for (int i = 1; i < 1000; ++i) {
+            disposables.push_back(subscription.subscribe([&handled] {
+                if (!handled)
+                    handled = true;
+            }));
+        }
+        measure("LambdaSubscription: 1k handlers ignoring handled event", 100000, [&] {
+            handled = false;
+            subscription.notifyAll();
+        });
+        measure("LambdaSubscription: 1k handlers until handled", 100000, [&] {
+            handled = false;
+            subscription.notifyUntilHandled();
+        });
+    }
+    notifyWeakObservers<LambdaSubscription>("LambdaSubscription: 10k weak_ptr lambdas");
+    notifyTrackableObservers("LambdaSubscription: 10k trackable observers");
+    connectAndDisconnectTrackableObservers("LambdaSubscription: 10k trackable observers, connect and disconnect");
+    notifyWeakObservers<BucketedLambdaSubscription>(
+        "BucketedLambdaSubscription: 10k weak_ptr lambdas");
+}
+
+}  // namespace benchmarks
@@ -0,0 +1,9 @@
+#include "benchmark.h"
+
+int main()
+{
+    benchmarks::classicSubscription();
+    benchmarks::lambdaSubscription();
+    benchmarks::basicSubscription();
+    return 0;
+}
@@ -3,6 +3,8 @@
 #include <string>
 #include <iostream>
 
+using namespace subscriptions;
+
 // casual listener interface
 struct IOnePropertyListener
 {
@@ -23,24 +25,19 @@ class Provider
 {
 public:
     template<class Func>
-    [[nodiscard]] LambdaSubscription::Disposable subscribeOnMyPropertyByLambda(Func func)
+    [[nodiscard]] Disposable subscribeOnMyPropertyByLambda(Func func)
     {
         return subscription.subscribe(func);
     }
 
-    [[nodiscard]] LambdaSubscription::Disposable subscribeOnMyPropertyByRawPointer(IOnePropertyListener *observer)
+    [[nodiscard]] Disposable subscribeOnMyPropertyByRawPointer(IOnePropertyListener *observer)
     {
-        return subscription.subscribe([observer]() { observer->onPropertyChanged(); });
+        return subscription.subscribe<&IOnePropertyListener::onPropertyChanged>(observer);
     }
 
-    [[nodiscard]] LambdaSubscription::Disposable subscribeOnMyPropertyByWeakPtr(std::weak_ptr<IOnePropertyListener> weak_observer)
+    [[nodiscard]] Disposable subscribeOnMyPropertyByWeakPtr(std::weak_ptr<IOnePropertyListener> weak_observer)
     {
-        return subscription.subscribe(
-                [weak_observer = std::move(weak_observer)]()
-                {
-                    if (auto lock = weak_observer.lock())
-                        lock->onPropertyChanged();
-                });
+        return subscription.subscribe<&IOnePropertyListener::onPropertyChanged>(std::move(weak_observer));
     }
 
     int myProperty() const { return myProperty_; }
@@ -70,7 +67,7 @@ public:
         notifyPearChanged();
     }
 
-    ClassicSubscription<IManyPropertiesListener>::Disposable subscribeOnManyProperties(IManyPropertiesListener* listener){
+    Disposable subscribeOnManyProperties(IManyPropertiesListener* listener){
         return classicSubscription.subscribe(listener);
     }
 private:
@@ -109,7 +106,7 @@ private:
 
 private:
     Provider &observable_;
-    LambdaSubscription::Disposable disposable;
+    Disposable disposable;
 };
 
 class ObserverByRawInterfacePointer : public IOnePropertyListener
@@ -129,7 +126,7 @@ private:
 
 private:
     Provider &observable_;
-    LambdaSubscription::Disposable disposable;
+    Disposable disposable;
 };
 
 class ObserverByLambda
@@ -149,7 +146,7 @@ private:
 
 private:
     Provider &observable_;
-    LambdaSubscription::Disposable disposable;
+    Disposable disposable;
 };
 
 class ManyPropertiesListener : public IManyPropertiesListener{
@@ -167,7 +164,7 @@ public:
 
 private:
     Provider& provider_;
-    ClassicSubscription<IManyPropertiesListener>::Disposable disposable_;
+    Disposable disposable_;
 };
 
 int main()
@@ -0,0 +1,496 @@
+#pragma once
+#include "ClassicSubscription.h"
+#include "LambdaSubscription.h"
+#include "callback.h"
+#include "combiners.h"
+#include "disposable.h"
+#include "policies.h"
+#include "shared_state.h"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace subscriptions {
+
+template <class Threading, class T>
+class BasicBehaviorSubscription;
+
+template <class Threading, class Clock, class... Args>
+class BasicReplaySubscription;
+
+// Subscription of callbacks taking Args, kept according to the Storage and Ordering policies
+template <class Threading, class Storage, class Ordering, class... Args>
+class BasicSubscription<void(Args...), Threading, Storage, Ordering> final {
+  using Id = std::uint64_t;
+  using Key = std::uint32_t;
+
+  static constexpr bool kIndexed = Storage::kIndexed;
+  static constexpr Key kNoPosition = std::numeric_limits<Key>::max();
+
+  // Callback which can be identified, zero id means released one.
+  // Indexed storage keeps the key in the low half of the id and a generation in the high one.
+  struct Entry {
+    Id id = 0;
+    internal::Callback<Args...> callback;
+  };
+
+  using Entries = typename Storage::template Container<Entry>;
+
+  struct State final : internal::SharedState<State, Threading> {
+    explicit State(std::pmr::memory_resource* resource)
+        : internal::SharedState<State, Threading>(resource)
+        , arena(resource)
+        , entries(resource)
+        , pending(resource)
+        , positions(resource)
+        , freeKeys(resource)
+        , holes(resource)
+    {
+    }
+
+    // Memory of large callables, declared first to outlive them
+    internal::CallbackArena arena;
+    Entries entries;
+    // Callbacks subscribed during notification, so entries do not move under a running one
+    std::pmr::vector<Entry> pending;
+    // Positions in entries by key of indexed storage, kNoPosition for pending ones
+    std::pmr::vector<Key> positions;
+    std::pmr::vector<Key> freeKeys;
+    // Positions released during notification. Unordered storage fills them with pending
+    // callbacks and then with the last ones instead of shifting the tail.
+    std::pmr::vector<size_t> holes;
+    Id lastId = 0;
+    int notifying = 0;
+    bool hasReleased = false;
+
+    Id add(internal::Callback<Args...> callback)
+    {
+      Id id = ++lastId;
+      if constexpr (kIndexed)
+        id = (id << 32) | acquireKey();
+      if (notifying) {
+        pending.push_back(Entry{id, std::move(callback)});
+      } else {
+        append(Entry{id, std::move(callback)});
+      }
+      return id;
+    }
+
+    void append(Entry&& entry)
+    {
+      if constexpr (kIndexed)
+        positions[keyOf(entry.id)] = static_cast<Key>(entries.size());
+      entries.push_back(std::move(entry));
+    }
+
+    void release(Id id) noexcept
+    {
+      const size_t position = find(id);
+      if (position != entries.size()) {
+        if (notifying) {
+          // The callback may be running, it is destroyed after notification
+          dropAt(position);
+        } else {
+          releaseKey(id);
+          erase(position);
+        }
+        return;
+      }
+      for (Entry& entry : pending) {
+        if (entry.id == id) {
+          drop(entry);
+          return;
+        }
+      }
+    }
+
+    // Prepares for notification, so releasing callbacks does not allocate
+    void beginNotification()
+    {
+      if (!Ordering::kPreservesOrder && notifying == 0)
+        holes.reserve(entries.size());
+      ++notifying;
+    }
+
+    // Marks the entry as released during notification, it is removed by clean
+    void dropAt(size_t position) noexcept
+    {
+      if constexpr (!Ordering::kPreservesOrder)
+        holes.push_back(position);
+      drop(entries[position]);
+    }
+
+    void drop(Entry& entry) noexcept
+    {
+      releaseKey(entry.id);
+      entry.id = 0;
+      hasReleased = true;
+    }
+
+    void clean()
+    {
+      if constexpr (!Ordering::kPreservesOrder)
+        fillHoles();
+      if (hasReleased) {
+        // Single pass keeping the order of the remaining callbacks
+        size_t kept = 0;
+        for (size_t i = 0; i < entries.size(); ++i) {
+          if (!entries[i].id)
+            continue;
+          if (kept != i)
+            entries[kept] = std::move(entries[i]);
+          if constexpr (kIndexed)
+            positions[keyOf(entries[kept].id)] = static_cast<Key>(kept);
+          ++kept;
+        }
+        while (entries.size() > kept)
+          entries.pop_back();
+        hasReleased = false;
+      }
+      if (!pending.empty()) {
+        for (Entry& entry : pending) {
+          if (entry.id)
+            append(std::move(entry));
+        }
+        pending.clear();
+      }
+      // Compaction is amortized by at least as many bytes released since the previous one
+      if (arena.releasedBytes() > 0 && arena.releasedBytes() >= arena.liveBytes()) {
+        arena.beginCompaction();
+        for (size_t i = 0; i < entries.size(); ++i)
+          entries[i].callback.relocate();
+        arena.endCompaction();
+      }
+    }
+
+    // Destroys callbacks of the dying subscription
+    void clear() noexcept
+    {
+      pending.clear();
+      entries.clear();
+    }
+
+  private:
+    static Key keyOf(Id id) noexcept { return static_cast<Key>(id); }
+
+    // Returns entries.size() if the entry is not there
+    size_t find(Id id) const noexcept
+    {
+      if constexpr (kIndexed) {
+        const Key position = positions[keyOf(id)];
+        if (position != kNoPosition && entries[position].id == id)
+          return position;
+      } else {
+        for (size_t i = 0; i < entries.size(); ++i) {
+          if (entries[i].id == id)
+            return i;
+        }
+      }
+      return entries.size();
+    }
+
+    // Moves pending callbacks and then the last callbacks into released places
+    void fillHoles() noexcept
+    {
+      auto next = pending.begin();
+      for (const size_t position : holes) {
+        while (next != pending.end() && !next->id)
+          ++next;
+        if (next != pending.end()) {
+          place(position, std::move(*next));
+          next->id = 0;
+          continue;
+        }
+        while (!entries.empty() && !entries.back().id)
+          entries.pop_back();
+        // Positions are unique, so a remaining one is released and the last callback is not
+        if (position < entries.size()) {
+          place(position, std::move(entries.back()));
+          entries.pop_back();
+        }
+      }
+      holes.clear();
+      hasReleased = false;
+    }
+
+    void place(size_t position, Entry&& entry) noexcept
+    {
+      if constexpr (kIndexed)
+        positions[keyOf(entry.id)] = static_cast<Key>(position);
+      entries[position] = std::move(entry);
+    }
+
+    void erase(size_t position) noexcept
+    {
+      if constexpr (Ordering::kPreservesOrder) {
+        for (size_t i = position + 1; i < entries.size(); ++i) {
+          entries[i - 1] = std::move(entries[i]);
+          if constexpr (kIndexed)
+            positions[keyOf(entries[i - 1].id)] = static_cast<Key>(i - 1);
+        }
+      } else if (position + 1 != entries.size()) {
+        entries[position] = std::move(entries.back());
+        if constexpr (kIndexed)
+          positions[keyOf(entries[position].id)] = static_cast<Key>(position);
+      }
+      entries.pop_back();
+    }
+
+    Key acquireKey()
+    {
+      if (freeKeys.empty()) {
+        positions.push_back(kNoPosition);
+        // Every key may be returned, so releasing never allocates
+        freeKeys.reserve(positions.size());
+        return static_cast<Key>(positions.size() - 1);
+      }
+      const Key key = freeKeys.back();
+      freeKeys.pop_back();
+      return key;
+    }
+
+    void releaseKey(Id id) noexcept
+    {
+      if constexpr (kIndexed) {
+        positions[keyOf(id)] = kNoPosition;
+        freeKeys.push_back(keyOf(id));
+      }
+    }
+  };
+
+  using Lock = std::lock_guard<typename Threading::Mutex>;
+
+  class DisposableImpl final : public internal::Disposable {
+  public:
+    DisposableImpl(State* state, Id id, std::pmr::memory_resource* resource)
+        : state_(state), id_(id), resource_(resource)
+    {
+      state_->addRef();
+    }
+
+    ~DisposableImpl() override
+    {
+      {
+        Lock lock(state_->mutex());
+        if (state_->alive())
+          state_->release(id_);
+      }
+      State::releaseRef(state_);
+    }
+
+    void destroy() noexcept override { internal::destroyAllocated(this, resource_); }
+
+  private:
+    State* state_;
+    Id id_;
+    std::pmr::memory_resource* resource_;
+  };
+
+public:
+  // Shared state, callables and handles are allocated from the resource
+  explicit BasicSubscription(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : resource_(resource)
+  {
+    // Concurrent subscription can't allocate the state lazily without a race
+    if constexpr (Threading::kConcurrent)
+      state_ = State::create(resource_);
+  }
+
+  BasicSubscription(BasicSubscription&& other) noexcept
+      : resource_(other.resource_), state_(std::exchange(other.state_, nullptr))
+  {
+  }
+
+  BasicSubscription& operator=(BasicSubscription&& other) noexcept
+  {
+    BasicSubscription subscription(std::move(other));
+    std::swap(resource_, subscription.resource_);
+    std::swap(state_, subscription.state_);
+    return *this;
+  }
+
+  ~BasicSubscription()
+  {
+    if (!state_)
+      return;
+    {
+      Lock lock(state_->mutex());
+      state_->kill();
+      state_->clear();
+    }
+    State::releaseRef(state_);
+  }
+
+  template <class Callback>
+  [[nodiscard]] Disposable subscribe(Callback callback)
+  {
+    static_assert(std::is_invocable<Callback, Args...>::value, "Only callable type allowed");
+    if (!state_)
+      state_ = State::create(resource_);
+    Lock lock(state_->mutex());
+    const Id id = state_->add(internal::Callback<Args...>(std::move(callback), &state_->arena));
+    return Disposable(internal::allocateDisposable<DisposableImpl>(resource_, state_, id, resource_));
+  }
+
+  // Subscribes a member function of the object. The object pointer with a statically bound call
+  // is kept in place of the callback, only the handle is allocated as for any callback.
+  template <auto Method, class T>
+  [[nodiscard]] Disposable subscribe(T* object)
+  {
+    static_assert(std::is_member_function_pointer_v<decltype(Method)>, "Method must be a member function");
+    return subscribe([object](Args... args) { (object->*Method)(std::forward<Args>(args)...); });
+  }
+
+  // Subscribes a member function of the observer while it is alive.
+  // The callback is removed during the first notification after the observer has expired.
+  template <auto Method, class T>
+  [[nodiscard]] Disposable subscribe(std::weak_ptr<T> observer)
+  {
+    static_assert(std::is_member_function_pointer_v<decltype(Method)>, "Method must be a member function");
+    return subscribe([observer = std::move(observer)](Args... args) {
+      const auto lock = observer.lock();
+      if (!lock)
+        return Retention::Drop;
+      ((*lock).*Method)(std::forward<Args>(args)...);
+      return Retention::Keep;
+    });
+  }
+
+  void notifyAll(Args... args)
+  {
+    notify([]() { return false; }, args...);
+  }
+
+private:
+  template <class, class, class, class>
+  friend class BasicSubscription;
+  template <class, class>
+  friend class BasicBehaviorSubscription;
+  template <class, class, class...>
+  friend class BasicReplaySubscription;
+
+  // Allocates the state on the first use
+  State& state()
+  {
+    if (!state_)
+      state_ = State::create(resource_);
+    return *state_;
+  }
+
+  // Notifies callbacks until stop returns true after a call
+  template <class Stop>
+  void notify(Stop stop, Args&... args)
+  {
+    if (!state_)
+      return;
+    State& state = *state_;
+    Lock lock(state.mutex());
+    state.beginNotification();
+    // Ends the notification even if a callback throws
+    struct Guard {
+      State& state;
+
+      ~Guard() noexcept(false)
+      {
+        if (--state.notifying == 0)
+          state.clean();
+      }
+    } guard{state};
+    for (size_t i = 0, size = state.entries.size(); i < size; ++i) {
+      Entry& entry = state.entries[i];
+      if (!entry.id)
+        continue;
+      if (!entry.callback(args...))
+        state.dropAt(i);
+      if (stop())
+        break;
+    }
+  }
+
+  std::pmr::memory_resource* resource_;
+  // Allocated on the first subscription, shared with handles
+  State* state_ = nullptr;
+};
+
+// Subscription of callbacks returning R, whose results are folded by notifyAll(combiner, args...).
+// Callbacks are kept by the void(Args...) subscription taking a place for the result first.
+template <class R, class Threading, class Storage, class Ordering, class... Args>
+class BasicSubscription<R(Args...), Threading, Storage, Ordering> final {
+  static_assert(!std::is_reference_v<R>, "Callbacks must return values");
+
+  using Result = std::optional<R>;
+  using Callbacks = BasicSubscription<void(Result&, Args...), Threading, Storage, Ordering>;
+
+public:
+  explicit BasicSubscription(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : callbacks_(resource)
+  {
+  }
+
+  template <class Callback>
+  [[nodiscard]] Disposable subscribe(Callback callback)
+  {
+    static_assert(std::is_invocable_r<R, Callback, Args...>::value, "Callback must return R");
+    return callbacks_.subscribe([callback = std::move(callback)](Result& result, Args... args) {
+      result.emplace(callback(std::forward<Args>(args)...));
+    });
+  }
+
+  template <auto Method, class T>
+  [[nodiscard]] Disposable subscribe(T* object)
+  {
+    static_assert(std::is_member_function_pointer_v<decltype(Method)>, "Method must be a member function");
+    return callbacks_.subscribe([object](Result& result, Args... args) {
+      result.emplace((object->*Method)(std::forward<Args>(args)...));
+    });
+  }
+
+  // Subscribes a member function of the observer while it is alive, an expired observer
+  // gives no result and is removed
+  template <auto Method, class T>
+  [[nodiscard]] Disposable subscribe(std::weak_ptr<T> observer)
+  {
+    static_assert(std::is_member_function_pointer_v<decltype(Method)>, "Method must be a member function");
+    return callbacks_.subscribe([observer = std::move(observer)](Result& result, Args... args) {
+      const auto lock = observer.lock();
+      if (!lock)
+        return Retention::Drop;
+      result.emplace(((*lock).*Method)(std::forward<Args>(args)...));
+      return Retention::Keep;
+    });
+  }
+
+  // Passes results to the combiner as callbacks return them, see combiners.h.
+  // Returns the combiner's result.
+  template <class Combiner>
+  auto notifyAll(Combiner combiner, Args... args)
+  {
+    Result result;
+    callbacks_.notify(
+        [&]() {
+          if (!result)
+            return false;
+          const bool proceed = internal::combine(combiner, std::move(*result));
+          result.reset();
+          return !proceed;
+        },
+        result,
+        args...);
+    return combiner.result();
+  }
+
+  // Notifies callbacks returning Propagation until one stops, returns whether one did
+  bool notifyUntilHandled(Args... args) { return notifyAll(Handled(), args...); }
+
+private:
+  Callbacks callbacks_;
+};
+
+}  // namespace subscriptions
@@ -0,0 +1,81 @@
+#pragma once
+#include "BasicSubscription.h"
+#include "callback.h"
+#include "disposable.h"
+#include "policies.h"
+
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace subscriptions {
+
+// Subscription keeping the last notified value, which a new callback receives on subscription.
+// Subscription and notification hold the same lock, so a callback doesn't miss a value
+// notified concurrently and doesn't receive an older one after it.
+template <class Threading, class T>
+class BasicBehaviorSubscription final {
+  using Callbacks = BasicSubscription<void(const T&), Threading>;
+  using Lock = std::lock_guard<typename Threading::Mutex>;
+
+public:
+  // There is no value until the first notification
+  explicit BasicBehaviorSubscription(
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : callbacks_(resource)
+  {
+  }
+
+  explicit BasicBehaviorSubscription(
+      T value, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : callbacks_(resource), value_(std::move(value))
+  {
+  }
+
+  // Calls the callback with the current value, if any, before subscribing it.
+  // Callback returning Retention::Drop then is not subscribed, a bool result is ignored.
+  template <class Callback>
+  [[nodiscard]] Disposable subscribe(Callback callback)
+  {
+    static_assert(std::is_invocable<Callback, const T&>::value, "Only callable type allowed");
+    Lock lock(callbacks_.state().mutex());
+    if (value_ && !internal::invokeRetained(callback, *value_))
+      return Disposable();
+    return callbacks_.subscribe(std::move(callback));
+  }
+
+  template <auto Method, class U>
+  [[nodiscard]] Disposable subscribe(U* object)
+  {
+    static_assert(std::is_member_function_pointer_v<decltype(Method)>, "Method must be a member function");
+    return subscribe([object](const T& value) { (object->*Method)(value); });
+  }
+
+  void notifyAll(T value)
+  {
+    Lock lock(callbacks_.state().mutex());
+    // Callbacks get the local value, a nested notification replaces the kept one
+    value_ = value;
+    callbacks_.notifyAll(value);
+  }
+
+  [[nodiscard]] std::optional<T> value() const
+  {
+    if (!callbacks_.state_)
+      return value_;
+    Lock lock(callbacks_.state_->mutex());
+    return value_;
+  }
+
+private:
+  Callbacks callbacks_;
+  // Guarded by the lock of callbacks' state
+  std::optional<T> value_;
+};
+
+template <class T>
+using BehaviorSubscription = BasicBehaviorSubscription<SingleThreaded, T>;
+
+}  // namespace subscriptions
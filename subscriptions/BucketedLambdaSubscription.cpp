@@ -0,0 +1,52 @@
+#include "BucketedLambdaSubscription.h"
+
+namespace subscriptions {
+
+BucketedLambdaSubscription::DisposableImpl::DisposableImpl(
+    std::weak_ptr<State> state, BucketBase* bucket, Id id)
+    : state_(std::move(state)), bucket_(bucket), id_(id)
+{
+}
+
+void BucketedLambdaSubscription::DisposableImpl::dispose() noexcept
+{
+    if (auto lock = state_.lock())
+        bucket_->release(id_, lock->notifying > 0);
+    state_.reset();
+    bucket_ = nullptr;
+    id_ = 0;
+}
+
+BucketedLambdaSubscription::BucketBase& BucketedLambdaSubscription::findBucket(
+    const void* type, std::unique_ptr<BucketBase> (*makeBucket)())
+{
+    for (auto& bucket : state_->buckets) {
+        if (bucket->type() == type)
+            return *bucket;
+    }
+    return *state_->buckets.emplace_back(makeBucket());
+}
+
+void BucketedLambdaSubscription::notifyAll()
+{
+    if (!state_)
+        return;
+    State& state = *state_;
+    ++state.notifying;
+    // Ends the notification even if a callback throws
+    struct Guard {
+        State& state;
+
+        ~Guard() noexcept(false)
+        {
+            if (--state.notifying == 0) {
+                for (auto& bucket : state.buckets)
+                    bucket->clean();
+            }
+        }
+    } guard{state};
+    for (size_t i = 0, size = state.buckets.size(); i < size; ++i)
+        state.buckets[i]->notify();
+}
+
+}  // namespace subscriptions
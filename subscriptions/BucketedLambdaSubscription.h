@@ -0,0 +1,176 @@
+#pragma once
+#include "disposable.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace subscriptions {
+
+// Lambda subscription which keeps callbacks of the same type in one contiguous array,
+// so notification runs a loop without type erasure per callback type.
+// Callbacks are notified grouped by their type in order of the first subscription of each type.
+class BucketedLambdaSubscription final {
+  using Id = std::uint64_t;
+
+  class BucketBase {
+  public:
+    explicit BucketBase(const void* type) : type_(type) {}
+
+    virtual ~BucketBase() = default;
+
+    [[nodiscard]] const void* type() const { return type_; }
+
+    virtual void notify() = 0;
+
+    virtual void release(Id id, bool notifying) noexcept = 0;
+
+    // Removes released callbacks and appends ones subscribed during notification
+    virtual void clean() = 0;
+
+  private:
+    const void* type_;
+  };
+
+  template <class Func>
+  class Bucket final : public BucketBase {
+  public:
+    Bucket() : BucketBase(typeTag<Func>()) {}
+
+    void add(Id id, Func func, bool notifying)
+    {
+      if (!notifying)
+        clean();
+      (notifying ? pending_ : items_).push_back(Item{id, std::move(func)});
+    }
+
+    void notify() override
+    {
+      for (size_t i = 0, size = items_.size(); i < size; ++i) {
+        const Item& item = items_[i];
+        if (item.id)
+          std::invoke(*item.func);
+      }
+    }
+
+    void release(Id id, bool notifying) noexcept override
+    {
+      for (auto* items : {&items_, &pending_}) {
+        for (size_t i = 0; i < items->size(); ++i) {
+          Item& item = (*items)[i];
+          if (item.id != id)
+            continue;
+          if (!notifying && std::is_nothrow_move_constructible_v<Func>) {
+            erase(i);
+          } else {
+            // The callback may be running, it is destroyed after notification
+            item.id = 0;
+            dirty_ = true;
+          }
+          return;
+        }
+      }
+    }
+
+    void clean() override
+    {
+      if (!dirty_ && pending_.empty())
+        return;
+      // Lambdas are not assignable, so live callbacks are moved into a new array
+      std::vector<Item> live;
+      live.reserve(items_.size() + pending_.size());
+      for (auto* items : {&items_, &pending_}) {
+        for (Item& item : *items) {
+          if (item.id)
+            live.push_back(std::move(item));
+        }
+      }
+      items_.swap(live);
+      pending_.clear();
+      dirty_ = false;
+    }
+
+  private:
+    // Lambdas are not assignable, so removal constructs them again in the optional
+    struct Item {
+      Id id;
+      std::optional<Func> func;
+    };
+
+    // Shifts the following callbacks keeping their order
+    void erase(size_t position) noexcept
+    {
+      for (size_t i = position + 1; i < items_.size(); ++i) {
+        items_[i - 1].id = items_[i].id;
+        items_[i - 1].func.reset();
+        items_[i - 1].func.emplace(std::move(*items_[i].func));
+      }
+      items_.pop_back();
+    }
+
+    std::vector<Item> items_;
+    // Callbacks subscribed during notification, items_ must not reallocate under a running callback
+    std::vector<Item> pending_;
+    bool dirty_ = false;
+  };
+
+  struct State {
+    std::vector<std::unique_ptr<BucketBase>> buckets;
+    Id lastId = 0;
+    int notifying = 0;
+  };
+
+  class DisposableImpl final : public internal::Disposable {
+  public:
+    DisposableImpl(std::weak_ptr<State> state, BucketBase* bucket, Id id);
+    ~DisposableImpl() override { dispose(); }
+
+  private:
+    void dispose() noexcept;
+
+    std::weak_ptr<State> state_;
+    BucketBase* bucket_;
+    Id id_;
+  };
+
+public:
+  template <class Callback>
+  [[nodiscard]] Disposable subscribe(Callback callback)
+  {
+    static_assert(std::is_invocable<Callback>::value, "Only callable type allowed");
+    if (!state_)
+      state_ = std::make_shared<State>();
+    auto& bucket = static_cast<Bucket<Callback>&>(
+        findBucket(typeTag<Callback>(), &makeBucket<Callback>));
+    const Id id = ++state_->lastId;
+    bucket.add(id, std::move(callback), state_->notifying > 0);
+    return Disposable(std::make_unique<DisposableImpl>(state_, &bucket, id));
+  }
+
+  void notifyAll();
+
+private:
+  template <class Func>
+  static const void* typeTag()
+  {
+    static const char tag = 0;
+    return &tag;
+  }
+
+  template <class Func>
+  static std::unique_ptr<BucketBase> makeBucket()
+  {
+    return std::make_unique<Bucket<Func>>();
+  }
+
+  BucketBase& findBucket(
+      const void* type, std::unique_ptr<BucketBase> (*makeBucket)());
+
+  // Allocated on the first subscription
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace subscriptions
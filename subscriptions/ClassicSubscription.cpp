@@ -1,42 +1,150 @@
 #include "ClassicSubscription.h"
 
+#include <algorithm>
 #include <cassert>
+#include <stdexcept>
+#include <utility>
 
 namespace subscriptions::internal {
 
-ClassicSubscriptionBase::DisposableImpl::DisposableImpl(
-    std::weak_ptr<std::vector<void*>> subscribers, void* pointer)
-    : subscribers_(std::move(subscribers)), pointer_(pointer)
+template <class Threading>
+ClassicSubscriptionBase<Threading>::State::State(
+    std::pmr::memory_resource* resource, size_t bucketCount, bool ordered)
+    : SharedState<State, Threading>(resource), buckets(resource), ordered(ordered)
 {
+  buckets.reserve(bucketCount);
+  for (size_t i = 0; i < bucketCount; ++i)
+    buckets.emplace_back(typename Bucket::allocator_type(resource));
 }
 
-void ClassicSubscriptionBase::DisposableImpl::dispose() noexcept
+template <class Threading>
+ClassicSubscriptionBase<Threading>::ClassicSubscriptionBase(
+    size_t bucketCount, bool ordered, std::pmr::memory_resource* resource)
+    : bucketCount_(bucketCount), ordered_(ordered), resource_(resource)
 {
-  if (auto subscribers = subscribers_.lock()) {
-    auto it = std::find(subscribers->begin(), subscribers->end(), pointer_);
-    assert(it != subscribers->end());
-    *it = nullptr;
+  // Concurrent subscription can't allocate the state lazily without a race
+  if constexpr (Threading::kConcurrent)
+    state_ = State::create(resource_, bucketCount_, ordered_);
+}
+
+template <class Threading>
+ClassicSubscriptionBase<Threading>::~ClassicSubscriptionBase()
+{
+  if (!state_)
+    return;
+  {
+    Lock lock(state_->mutex());
+    state_->kill();
   }
-  subscribers_.reset();
+  State::releaseRef(state_);
+}
+
+template <class Threading>
+ClassicSubscriptionBase<Threading>::DisposableImpl::DisposableImpl(
+    State* state, size_t bucket, void* pointer, std::pmr::memory_resource* resource)
+    : state_(state), bucket_(bucket), pointer_(pointer), resource_(resource)
+{
+  state_->addRef();
+}
+
+template <class Threading>
+void ClassicSubscriptionBase<Threading>::DisposableImpl::dispose() noexcept
+{
+  if (!state_)
+    return;
+  {
+    Lock lock(state_->mutex());
+    if (state_->alive()) {
+      auto& subscribers = state_->buckets[bucket_];
+      auto it = std::find_if(subscribers.begin(), subscribers.end(), [p = pointer_](auto& s) {
+        return s.pointer == p;
+      });
+      assert(it != subscribers.end());
+      if (!state_->ordered && !state_->notifying) {
+        *it = subscribers.back();
+        subscribers.pop_back();
+      } else {
+        *it = Subscriber{nullptr, 0};
+        state_->hasReleased = true;
+      }
+      state_->frozen = false;
+    }
+  }
+  State::releaseRef(std::exchange(state_, nullptr));
   pointer_ = nullptr;
 }
 
-subscriptions::Disposable ClassicSubscriptionBase::subscribe(void* p)
+template <class Threading>
+void ClassicSubscriptionBase<Threading>::freeze()
+{
+  if (!state_)
+    return;
+  Lock lock(state_->mutex());
+  if (state_->notifying)
+    return;
+  clean_released();
+  for (auto& subscribers : state_->buckets)
+    subscribers.shrink_to_fit();
+  state_->frozen = true;
+}
+
+template <class Threading>
+typename ClassicSubscriptionBase<Threading>::State& ClassicSubscriptionBase<Threading>::state()
+{
+  if (!state_)
+    state_ = State::create(resource_, bucketCount_, ordered_);
+  return *state_;
+}
+
+template <class Threading>
+subscriptions::Disposable ClassicSubscriptionBase<Threading>::subscribe(
+    void* p, InterestMask interest, size_t bucket)
 {
   if (!p)
     throw std::runtime_error("Interface pointer must be not null");
 
-  if (std::find(subscribers_->begin(), subscribers_->end(), p) != subscribers_->end())
-    throw std::runtime_error("Subscribe twice is not allowed");
+  Lock lock(state().mutex());
 
-  subscribers_->push_back(p);
-  return subscriptions::Disposable(std::make_unique<DisposableImpl>(subscribers_, p));
+  for (auto& subscribers : state_->buckets) {
+    auto it = std::find_if(
+        subscribers.begin(), subscribers.end(), [p](auto& s) { return s.pointer == p; });
+    if (it != subscribers.end())
+      throw std::runtime_error("Subscribe twice is not allowed");
+  }
+
+  state_->buckets.at(bucket).push_back({p, interest});
+  state_->frozen = false;
+  return subscriptions::Disposable(
+      allocateDisposable<DisposableImpl>(resource_, state_, bucket, p, resource_));
 }
 
-void ClassicSubscriptionBase::clean_released()
+template <class Threading>
+void ClassicSubscriptionBase<Threading>::clean_released()
 {
-  subscribers_->erase(
-      std::remove(subscribers_->begin(), subscribers_->end(), nullptr), subscribers_->end());
+  if (!state_ || state_->notifying || !state_->hasReleased)
+    return;
+  for (auto& subscribers : state_->buckets) {
+    if (state_->ordered) {
+      subscribers.erase(
+          std::remove_if(
+              subscribers.begin(), subscribers.end(), [](auto& s) { return s.pointer == nullptr; }),
+          subscribers.end());
+      continue;
+    }
+    // Released places are taken by the last subscribers instead of shifting the tail
+    for (size_t i = 0; i < subscribers.size(); ++i) {
+      while (!subscribers.empty() && !subscribers.back().pointer)
+        subscribers.pop_back();
+      if (i < subscribers.size() && !subscribers[i].pointer) {
+        subscribers[i] = subscribers.back();
+        subscribers.pop_back();
+      }
+    }
+  }
+  state_->hasReleased = false;
 }
 
-}
\ No newline at end of file
+template class ClassicSubscriptionBase<SingleThreaded>;
+template class ClassicSubscriptionBase<MultiThreaded>;
+
+}
@@ -1,57 +1,321 @@
 #pragma once
+#include "aligned_allocator.h"
+#include "combiners.h"
 #include "disposable.h"
+#include "policies.h"
+#include "shared_state.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace subscriptions {
 
 namespace internal {
+template <class Threading>
 class ClassicSubscriptionBase {
 public:
-  ClassicSubscriptionBase()
-      : subscribers_(std::make_shared<std::vector<void *>>()) {}
+  // One bit per interface member a subscriber is interested in
+  using InterestMask = std::uint64_t;
+
+  static constexpr InterestMask kAllMembers = ~InterestMask(0);
+  // Bit of members which no subscriber has declared interest in
+  static constexpr InterestMask kUnlistedMember = InterestMask(1) << 63;
+  static constexpr size_t kMaxListedMembers = 63;
+
+  // Released subscriber has null pointer and no interest,
+  // so notification checks only the interest
+  struct Subscriber {
+    void* pointer;
+    InterestMask interest;
+  };
+
+  using Bucket = std::vector<Subscriber, CacheLineAllocator<Subscriber>>;
+
+  struct State final : SharedState<State, Threading> {
+    State(std::pmr::memory_resource* resource, size_t bucketCount, bool ordered);
+
+    // Subscribers grouped by their concrete type, the first bucket is for any type
+    std::pmr::vector<Bucket> buckets;
+    int notifying = 0;
+    bool hasReleased = false;
+    bool frozen = false;
+    // Unordered subscribers are swap-removed outside notification
+    bool ordered = true;
+  };
+
+  using Lock = std::lock_guard<typename Threading::Mutex>;
+
+  ClassicSubscriptionBase(size_t bucketCount, bool ordered, std::pmr::memory_resource* resource);
+
+  ClassicSubscriptionBase(ClassicSubscriptionBase&& other) noexcept
+      : state_(std::exchange(other.state_, nullptr))
+      , bucketCount_(other.bucketCount_)
+      , ordered_(other.ordered_)
+      , resource_(other.resource_)
+  {
+  }
+
+  ClassicSubscriptionBase& operator=(ClassicSubscriptionBase&& other) noexcept
+  {
+    ClassicSubscriptionBase subscription(std::move(other));
+    std::swap(state_, subscription.state_);
+    std::swap(bucketCount_, subscription.bucketCount_);
+    std::swap(ordered_, subscription.ordered_);
+    std::swap(resource_, subscription.resource_);
+    return *this;
+  }
+
+  ~ClassicSubscriptionBase();
 
   class DisposableImpl final : public Disposable {
   public:
-    DisposableImpl(std::weak_ptr<std::vector<void *>> subscribers,
-                   void *pointer);
+    DisposableImpl(State* state, size_t bucket,
+                   void *pointer, std::pmr::memory_resource* resource);
 
     ~DisposableImpl() override { dispose(); }
 
+    void destroy() noexcept override { destroyAllocated(this, resource_); }
+
   private:
     void dispose() noexcept;
-    std::weak_ptr<std::vector<void *>> subscribers_;
+    State* state_;
+    size_t bucket_;
     void *pointer_ = nullptr;
+    std::pmr::memory_resource* resource_;
   };
 
+  // Removes released subscribers and trims every bucket to its size. Notification keeps its loop,
+  // which already runs over contiguous subscribers of a bucket. Buckets are not merged, so
+  // notifyEach still passes concrete listeners by their type. frozen() is reset by the next
+  // subscription or unsubscription. Has no effect during notification.
+  void freeze();
+
+  [[nodiscard]] bool frozen() const
+  {
+    if (!state_)
+      return false;
+    Lock lock(state_->mutex());
+    return state_->frozen;
+  }
+
 protected:
-  [[nodiscard]] subscriptions::Disposable subscribe(void *p);
+  [[nodiscard]] subscriptions::Disposable subscribe(
+      void *p, InterestMask interest, size_t bucket = 0);
 
   void clean_released();
 
+  // Allocates the state on the first use
+  State& state();
+
 protected:
-  std::shared_ptr<std::vector<void *>> subscribers_;
+  // Allocated on the first subscription, shared with handles
+  State* state_ = nullptr;
+  size_t bucketCount_;
+  bool ordered_;
+  std::pmr::memory_resource* resource_;
 };
 }
 
-template <class Interface>
-class ClassicSubscription final : public internal::ClassicSubscriptionBase {
+// Subscription notifying members of Interface, see Listeners
+template <class Interface, class... Concretes, class Threading, class Ordering>
+class BasicSubscription<Listeners<Interface, Concretes...>, Threading, VectorStorage, Ordering> final
+    : public internal::ClassicSubscriptionBase<Threading> {
+  using Base = internal::ClassicSubscriptionBase<Threading>;
+  using typename Base::Bucket;
+  using typename Base::InterestMask;
+  using typename Base::Lock;
+  using typename Base::Subscriber;
+  using Base::kAllMembers;
+  using Base::kMaxListedMembers;
+  using Base::kUnlistedMember;
+  using Base::state_;
+
+  static_assert((std::is_final_v<Concretes> && ...), "Concrete listeners must be final");
+  static_assert(
+      (std::is_base_of_v<Interface, Concretes> && ...), "Concrete listeners must implement Interface");
+
 public:
+  // Shared state and handles are allocated from the resource
+  explicit BasicSubscription(
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : Base(1 + sizeof...(Concretes), Ordering::kPreservesOrder, resource)
+      , listedMembers_(resource)
+  {
+  }
+
+  // Subscribes on all members of Interface
   [[nodiscard]] Disposable subscribe(Interface* anInterface)
   {
-    return ClassicSubscriptionBase::subscribe(anInterface);
+    return Base::subscribe(anInterface, kAllMembers);
   }
 
+  // Subscribes only on the listed members, notifications of others skip the listener.
+  // If no member is listed the listener is subscribed on all members.
+  // Listeners are kept in one list with a mask of members, which notification tests,
+  // so disposal doesn't search several lists.
+  template <class Listener, typename... Members>
+  [[nodiscard]] Disposable subscribe(Listener* listener, Members... members)
+  {
+    static_assert(std::is_base_of_v<Interface, Listener>, "Listener must implement Interface");
+    Lock lock(this->state().mutex());
+    const InterestMask interest =
+        sizeof...(Members) == 0 ? kAllMembers : (InterestMask(0) | ... | listMember(members));
+    return Base::subscribe(
+        static_cast<Interface*>(listener), interest, bucketOf<Listener>());
+  }
+
+  // Listeners of other types are notified first, then listeners of each of Concretes
+  // in their order. So the order differs from subscription order across the types.
+  // Calls through the member pointer go through the vtable even for Concretes, see notifyEach.
   template <typename... Args>
   void notifyAll(void (Interface::*member)(Args...), Args... args)
   {
-    const auto size = subscribers_->size();
+    notify(member, [&](auto* listener) {
+      (listener->*member)(args...);
+      return true;
+    });
+  }
+
+  // Passes results of the member to the combiner as listeners return them, see combiners.h.
+  // Returns the combiner's result.
+  template <class Combiner, class R, typename... Args>
+  auto notifyAll(Combiner combiner, R (Interface::*member)(Args...), Args... args)
+  {
+    notify(member, [&](auto* listener) {
+      return internal::combine(combiner, (listener->*member)(args...));
+    });
+    return combiner.result();
+  }
+
+  // Calls call(listener) for listeners interested in the member, in the order of notifyAll.
+  // Listeners of Concretes are passed as pointers of their type, so a generic call naming
+  // the member, like [](auto* listener) { listener->onChanged(1); }, is statically bound for them.
+  template <class R, typename... Args, class Call>
+  void notifyEach(R (Interface::*member)(Args...), Call call)
+  {
+    notify(member, [&call](auto* listener) {
+      call(listener);
+      return true;
+    });
+  }
+
+  // Notifies listeners until one returns Propagation::Stop, returns whether one did
+  template <typename... Args>
+  bool notifyUntilHandled(Propagation (Interface::*member)(Args...), Args... args)
+  {
+    return notifyAll(Handled(), member, args...);
+  }
+
+private:
+  // Members of any signature compared by their representation
+  struct MemberKey {
+    template <class Member>
+    explicit MemberKey(Member member) noexcept
+    {
+      static_assert(sizeof(Member) == sizeof(bytes), "Member pointers of Interface differ in size");
+      std::memcpy(bytes, &member, sizeof(bytes));
+    }
+
+    bool operator==(const MemberKey& other) const noexcept
+    {
+      return std::memcmp(bytes, other.bytes, sizeof(bytes)) == 0;
+    }
+
+    unsigned char bytes[sizeof(void (Interface::*)())];
+  };
+
+  template <class Listener>
+  static constexpr size_t bucketOf()
+  {
+    size_t bucket = 0;
+    size_t index = 1;
+    ((std::is_same_v<Listener, Concretes> ? bucket = index : ++index), ...);
+    return bucket;
+  }
+
+  // Calls visit with listeners interested in the member until it returns false
+  template <class Member, class Visit>
+  void notify(Member member, Visit visit)
+  {
+    if (!state_)
+      return;
+    Lock lock(state_->mutex());
+    const InterestMask bit = memberBit(member);
+    ++state_->notifying;
+    // Ends the notification even if a listener throws
+    struct Guard {
+      BasicSubscription& subscription;
+
+      ~Guard()
+      {
+        --subscription.state_->notifying;
+        subscription.clean_released();
+      }
+    } guard{*this};
+    notifyBucket<Interface>(0, bit, visit) &&
+        notifyConcretes(std::index_sequence_for<Concretes...>(), bit, visit);
+  }
+
+  template <size_t... Indices, class Visit>
+  bool notifyConcretes(
+      std::index_sequence<Indices...>, [[maybe_unused]] InterestMask bit, [[maybe_unused]] Visit& visit)
+  {
+    return (notifyBucket<Concretes>(Indices + 1, bit, visit) && ...);
+  }
+
+  template <class Listener, class Visit>
+  bool notifyBucket(size_t bucket, InterestMask bit, Visit& visit)
+  {
+    // Buckets are never added, so the reference survives subscription during the loop
+    const Bucket& subscribers = state_->buckets[bucket];
+    const auto size = subscribers.size();
     for (size_t i = 0; i < size; ++i) {
-      Interface* anInterface = static_cast<Interface*>(subscribers_->at(i));
-      if (anInterface)
-        (anInterface->*member)(args...);
+      const Subscriber& subscriber = subscribers[i];
+      if (subscriber.interest & bit) {
+        auto* listener = static_cast<Listener*>(static_cast<Interface*>(subscriber.pointer));
+        if (!visit(listener))
+          return false;
+      }
     }
-    clean_released();
+    return true;
   }
+
+  template <class R, typename... Args>
+  InterestMask memberBit(R (Interface::*member)(Args...)) const
+  {
+    const MemberKey key(member);
+    for (size_t i = 0; i < listedMembers_.size(); ++i) {
+      if (listedMembers_[i] == key)
+        return InterestMask(1) << i;
+    }
+    return kUnlistedMember;
+  }
+
+  template <class R, typename... Args>
+  InterestMask listMember(R (Interface::*member)(Args...))
+  {
+    const InterestMask bit = memberBit(member);
+    if (bit != kUnlistedMember)
+      return bit;
+    if (listedMembers_.size() == kMaxListedMembers)
+      throw std::runtime_error("Too many members are listed");
+    listedMembers_.push_back(MemberKey(member));
+    return InterestMask(1) << (listedMembers_.size() - 1);
+  }
+
+  std::pmr::vector<MemberKey> listedMembers_;
 };
 
-}
\ No newline at end of file
+template <class Threading, class Interface, class... Concretes>
+using BasicClassicSubscription = BasicSubscription<Listeners<Interface, Concretes...>, Threading>;
+
+template <class Interface, class... Concretes>
+using ClassicSubscription = BasicClassicSubscription<SingleThreaded, Interface, Concretes...>;
+
+}
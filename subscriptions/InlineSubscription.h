@@ -0,0 +1,175 @@
+#pragma once
+#include "callback.h"
+#include "disposable.h"
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace subscriptions {
+
+// Subscription which keeps first N callbacks inside the object and spills others to the heap.
+// Handles and the subscription point to each other, so no shared state is allocated.
+// Each handle is still allocated on the heap: it may outlive the subscription, so it can't
+// be kept in the inline storage. Only the callbacks are free of heap usage up to N.
+// The object is not movable, since handles refer to it.
+template <size_t N, class... Args>
+class InlineSubscription final {
+  static_assert(N > 0, "Inline capacity must be positive");
+
+  using Callback = internal::Callback<Args...>;
+
+  class DisposableImpl final : public internal::Disposable {
+  public:
+    DisposableImpl(InlineSubscription* subscription, size_t index, bool pending)
+        : subscription_(subscription), index_(index), pending_(pending)
+    {
+    }
+
+    ~DisposableImpl() override
+    {
+      if (subscription_)
+        subscription_->release(*this);
+    }
+
+  private:
+    friend class InlineSubscription;
+
+    InlineSubscription* subscription_;
+    size_t index_;
+    bool pending_;
+  };
+
+  // Entry without a handle is a released one
+  struct Entry {
+    Callback callback;
+    DisposableImpl* handle = nullptr;
+  };
+
+public:
+  InlineSubscription() = default;
+
+  InlineSubscription(const InlineSubscription&) = delete;
+
+  InlineSubscription& operator=(const InlineSubscription&) = delete;
+
+  ~InlineSubscription()
+  {
+    for (size_t i = 0; i < size_; ++i)
+      detach(at(i));
+    for (Entry& entry : pending_)
+      detach(entry);
+  }
+
+  // Allocates the handle on the heap, see above
+  template <class Func>
+  [[nodiscard]] Disposable subscribe(Func func)
+  {
+    static_assert(std::is_invocable<Func, Args...>::value, "Only callable type allowed");
+    Entry entry{Callback(std::move(func)), nullptr};
+    const bool pending = notifying_ > 0;
+    auto handle = std::make_unique<DisposableImpl>(this, pending ? pending_.size() : size_, pending);
+    entry.handle = handle.get();
+    if (pending)
+      pending_.push_back(std::move(entry));
+    else
+      append(std::move(entry));
+    return Disposable(std::move(handle));
+  }
+
+  void notifyAll(Args... args)
+  {
+    ++notifying_;
+    // Ends the notification even if a callback throws
+    struct Guard {
+      InlineSubscription& subscription;
+
+      ~Guard() noexcept(false)
+      {
+        if (--subscription.notifying_ == 0)
+          subscription.clean();
+      }
+    } guard{*this};
+    for (size_t i = 0, size = size_; i < size; ++i) {
+      Entry& entry = at(i);
+      if (entry.handle && !entry.callback(args...)) {
+        detach(entry);
+        hasReleased_ = true;
+      }
+    }
+  }
+
+private:
+  Entry& at(size_t index) { return index < N ? inline_[index] : spill_[index - N]; }
+
+  void append(Entry&& entry)
+  {
+    if (size_ < N)
+      inline_[size_] = std::move(entry);
+    else
+      spill_.push_back(std::move(entry));
+    ++size_;
+  }
+
+  static void detach(Entry& entry) noexcept
+  {
+    if (entry.handle) {
+      entry.handle->subscription_ = nullptr;
+      entry.handle = nullptr;
+    }
+  }
+
+  void release(DisposableImpl& handle) noexcept
+  {
+    Entry& entry = handle.pending_ ? pending_[handle.index_] : at(handle.index_);
+    detach(entry);
+    hasReleased_ = true;
+    // During notification the callback may be running, it is destroyed afterwards
+    if (!notifying_)
+      clean();
+  }
+
+  // Removes released entries keeping the order and appends pending ones
+  void clean()
+  {
+    if (hasReleased_) {
+      size_t live = 0;
+      for (size_t i = 0; i < size_; ++i) {
+        Entry& entry = at(i);
+        if (!entry.handle)
+          continue;
+        if (live != i) {
+          Entry& target = at(live);
+          target.callback = std::move(entry.callback);
+          target.handle = std::exchange(entry.handle, nullptr);
+          target.handle->index_ = live;
+        }
+        ++live;
+      }
+      for (size_t i = live; i < size_; ++i)
+        at(i).callback.reset();
+      spill_.resize(live > N ? live - N : 0);
+      size_ = live;
+      hasReleased_ = false;
+    }
+    for (Entry& entry : pending_) {
+      if (!entry.handle)
+        continue;
+      entry.handle->index_ = size_;
+      entry.handle->pending_ = false;
+      append(std::move(entry));
+    }
+    pending_.clear();
+  }
+
+  Entry inline_[N];
+  std::vector<Entry> spill_;
+  size_t size_ = 0;
+  // Callbacks subscribed during notification
+  std::vector<Entry> pending_;
+  int notifying_ = 0;
+  bool hasReleased_ = false;
+};
+
+}  // namespace subscriptions
@@ -0,0 +1,77 @@
+#include "IntrusiveSubscription.h"
+
+namespace subscriptions {
+
+void SubscriptionHook::unlink() noexcept
+{
+    if (subscription_)
+        subscription_->unlink(*this);
+}
+
+IntrusiveSubscription::~IntrusiveSubscription()
+{
+    for (SubscriptionHook* hook = head_; hook;) {
+        SubscriptionHook* next = hook->next_;
+        hook->subscription_ = nullptr;
+        hook->prev_ = nullptr;
+        hook->next_ = nullptr;
+        hook = next;
+    }
+}
+
+void IntrusiveSubscription::link(SubscriptionHook& hook, void* object, void (*invoker)(void*))
+{
+    hook.unlink();
+    hook.subscription_ = this;
+    hook.object_ = object;
+    hook.invoker_ = invoker;
+    hook.linkedAt_ = notifications_;
+    hook.prev_ = tail_;
+    hook.next_ = nullptr;
+    if (tail_)
+        tail_->next_ = &hook;
+    else
+        head_ = &hook;
+    tail_ = &hook;
+}
+
+void IntrusiveSubscription::unlink(SubscriptionHook& hook) noexcept
+{
+    for (Cursor* cursor = cursors_; cursor; cursor = cursor->outer) {
+        if (cursor->next == &hook)
+            cursor->next = hook.next_;
+    }
+    if (hook.prev_)
+        hook.prev_->next_ = hook.next_;
+    else
+        head_ = hook.next_;
+    if (hook.next_)
+        hook.next_->prev_ = hook.prev_;
+    else
+        tail_ = hook.prev_;
+    hook.subscription_ = nullptr;
+    hook.prev_ = nullptr;
+    hook.next_ = nullptr;
+}
+
+void IntrusiveSubscription::notifyAll()
+{
+    struct Guard {
+        IntrusiveSubscription& subscription;
+        Cursor cursor;
+
+        ~Guard() { subscription.cursors_ = cursor.outer; }
+    } guard{*this, {head_, cursors_}};
+    cursors_ = &guard.cursor;
+
+    const auto notification = ++notifications_;
+    while (SubscriptionHook* hook = guard.cursor.next) {
+        // Hooks are appended, so the rest are linked during this notification
+        if (hook->linkedAt_ >= notification)
+            break;
+        guard.cursor.next = hook->next_;
+        hook->invoker_(hook->object_);
+    }
+}
+
+}  // namespace subscriptions
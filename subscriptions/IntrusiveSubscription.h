@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+namespace subscriptions {
+
+class IntrusiveSubscription;
+
+// List node embedded into a subscriber. Subscription links it without any allocation,
+// the hook unlinks itself on destruction.
+class SubscriptionHook final {
+public:
+  SubscriptionHook() = default;
+
+  SubscriptionHook(const SubscriptionHook&) = delete;
+
+  SubscriptionHook& operator=(const SubscriptionHook&) = delete;
+
+  ~SubscriptionHook() { unlink(); }
+
+  [[nodiscard]] bool linked() const { return subscription_ != nullptr; }
+
+  void unlink() noexcept;
+
+private:
+  friend class IntrusiveSubscription;
+
+  IntrusiveSubscription* subscription_ = nullptr;
+  SubscriptionHook* prev_ = nullptr;
+  SubscriptionHook* next_ = nullptr;
+  void* object_ = nullptr;
+  void (*invoker_)(void*) = nullptr;
+  // Number of notifications started before the hook was linked
+  std::uint64_t linkedAt_ = 0;
+};
+
+// Subscription which links subscribers' hooks into an intrusive list.
+// Hooks may be unlinked and linked during notification, the linked ones are not notified
+// until the next notification.
+class IntrusiveSubscription final {
+public:
+  IntrusiveSubscription() = default;
+
+  IntrusiveSubscription(const IntrusiveSubscription&) = delete;
+
+  IntrusiveSubscription& operator=(const IntrusiveSubscription&) = delete;
+
+  ~IntrusiveSubscription();
+
+  // Links the hook, calling the member function of the object on notification.
+  // A hook linked elsewhere is unlinked first.
+  template <auto Method, class T>
+  void subscribe(SubscriptionHook& hook, T* object)
+  {
+    static_assert(std::is_member_function_pointer_v<decltype(Method)>, "Method must be a member function");
+    link(hook, object, [](void* o) { (static_cast<T*>(o)->*Method)(); });
+  }
+
+  void notifyAll();
+
+private:
+  friend class SubscriptionHook;
+
+  // Position of a notification in progress, nested notifications make a chain
+  struct Cursor {
+    SubscriptionHook* next;
+    Cursor* outer;
+  };
+
+  void link(SubscriptionHook& hook, void* object, void (*invoker)(void*));
+
+  void unlink(SubscriptionHook& hook) noexcept;
+
+  SubscriptionHook* head_ = nullptr;
+  SubscriptionHook* tail_ = nullptr;
+  Cursor* cursors_ = nullptr;
+  std::uint64_t notifications_ = 0;
+};
+
+}  // namespace subscriptions
@@ -1,39 +1,561 @@
 #include "LambdaSubscription.h"
 
-#include <cassert>
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
 
 namespace subscriptions {
 
-LambdaSubscription::DisposableImpl::DisposableImpl(
-    std::weak_ptr<std::vector<IdentityCallable>> callbacks, IdentityCallable::Identity identity)
-    : callbacks_(std::move(callbacks)), identity_(identity)
+template <class Threading>
+BasicSubscription<void(), Threading, VectorStorage, Ordered>::DisposableImpl::DisposableImpl(
+    State* state, std::pmr::memory_resource* resource, HandleBlock* block)
+    : state_(state), id_(0), resource_(resource), block_(block)
 {
+    state_->addRef();
 }
 
-void LambdaSubscription::DisposableImpl::dispose() noexcept
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::DisposableImpl::destroy() noexcept
 {
-    if (auto lock = callbacks_.lock()) {
-        auto it = std::find_if(lock->begin(), lock->end(), [id = identity_](IdentityCallable& c) {
-            return c.identity() == id;
+    if (!block_) {
+        // Disposed here, so the state survives the destructor to take the memory back
+        State* state = std::exchange(state_, nullptr);
+        {
+            Lock lock(state->mutex());
+            if (state->alive() && id_)
+                state->release(id_);
+            this->~DisposableImpl();
+            state->deallocateHandle(this);
+        }
+        State::releaseRef(state);
+        return;
+    }
+    HandleBlock* block = block_;
+    std::pmr::memory_resource* resource = resource_;
+    this->~DisposableImpl();
+    HandleBlock::release(block, resource);
+}
+
+template <class Threading>
+auto BasicSubscription<void(), Threading, VectorStorage, Ordered>::HandleBlock::create(
+    State* state, size_t count, std::pmr::memory_resource* resource) -> DisposableImpl*
+{
+    void* memory = resource->allocate(
+        kHandlesOffset + count * sizeof(DisposableImpl),
+        std::max(alignof(HandleBlock), alignof(DisposableImpl)));
+    auto* block = new (memory) HandleBlock(count);
+    auto* handles = reinterpret_cast<DisposableImpl*>(static_cast<std::byte*>(memory) + kHandlesOffset);
+    for (size_t i = 0; i < count; ++i)
+        new (handles + i) DisposableImpl(state, resource, block);
+    return handles;
+}
+
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::HandleBlock::release(
+    HandleBlock* block, std::pmr::memory_resource* resource) noexcept
+{
+    if (--block->live != 0)
+        return;
+    const size_t count = block->count;
+    block->~HandleBlock();
+    resource->deallocate(
+        block,
+        kHandlesOffset + count * sizeof(DisposableImpl),
+        std::max(alignof(HandleBlock), alignof(DisposableImpl)));
+}
+
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::DisposableImpl::dispose() noexcept
+{
+    if (!state_)
+        return;
+    {
+        Lock lock(state_->mutex());
+        if (state_->alive() && id_)
+            state_->release(id_);
+        id_ = 0;
+    }
+    State::releaseRef(std::exchange(state_, nullptr));
+}
+
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::DisposableImpl::disposeBatch(
+    internal::DisposablePtr* handles, size_t count) noexcept
+{
+    auto idOf = [](const internal::DisposablePtr& handle) {
+        return static_cast<const DisposableImpl&>(*handle).id_;
+    };
+    Lock lock(state_->mutex());
+    std::sort(handles, handles + count, [&idOf](const auto& a, const auto& b) {
+        return idOf(a) < idOf(b);
+    });
+    if (state_->alive())
+        state_->releaseSorted(handles, count);
+    for (size_t i = 0; i < count; ++i)
+        static_cast<DisposableImpl&>(*handles[i]).id_ = 0;
+}
+
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::TrackedImpl::disconnect() noexcept
+{
+    {
+        Lock lock(state_->mutex());
+        connected_ = false;
+        if (--owners_ != 0)
+            return;
+    }
+    internal::destroyAllocated(this, resource_);
+}
+
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::TrackedImpl::release() noexcept
+{
+    // The subscription still holds the state, so releasing it here doesn't destroy it under its lock
+    if (--owners_ == 0)
+        internal::destroyAllocated(this, resource_);
+}
+
+namespace {
+// Pooled handles follow the chunk's header
+template <class Chunk, class Handle>
+constexpr size_t kPooledHandlesOffset =
+    (sizeof(Chunk) + alignof(Handle) - 1) / alignof(Handle) * alignof(Handle);
+
+constexpr size_t kMaxHandleChunk = 64;
+}  // namespace
+
+template <class Threading>
+BasicSubscription<void(), Threading, VectorStorage, Ordered>::State::~State()
+{
+    constexpr size_t offset = kPooledHandlesOffset<HandleChunk, DisposableImpl>;
+    constexpr size_t alignment = std::max(alignof(HandleChunk), alignof(DisposableImpl));
+    std::pmr::memory_resource* resource = buckets.get_allocator().resource();
+    while (HandleChunk* chunk = handleChunks) {
+        handleChunks = chunk->next;
+        resource->deallocate(chunk, offset + chunk->count * sizeof(DisposableImpl), alignment);
+    }
+}
+
+template <class Threading>
+void* BasicSubscription<void(), Threading, VectorStorage, Ordered>::State::allocateHandle()
+{
+    if (!freeHandles) {
+        constexpr size_t offset = kPooledHandlesOffset<HandleChunk, DisposableImpl>;
+        constexpr size_t alignment = std::max(alignof(HandleChunk), alignof(DisposableImpl));
+        // Chunks grow, so a few handles take little memory and many take few chunks
+        const size_t count = handleChunks ? std::min(handleChunks->count * 2, kMaxHandleChunk) : 4;
+        void* memory = buckets.get_allocator().resource()->allocate(
+            offset + count * sizeof(DisposableImpl), alignment);
+        handleChunks = new (memory) HandleChunk{handleChunks, count};
+        std::byte* handles = static_cast<std::byte*>(memory) + offset;
+        for (size_t i = count; i-- > 0;)
+            deallocateHandle(handles + i * sizeof(DisposableImpl));
+    }
+    void* memory = freeHandles;
+    freeHandles = *static_cast<void**>(memory);
+    return memory;
+}
+
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::State::deallocateHandle(
+    void* memory) noexcept
+{
+    *static_cast<void**>(memory) = freeHandles;
+    freeHandles = memory;
+}
+
+template <class Threading>
+BasicSubscription<void(), Threading, VectorStorage, Ordered>::~BasicSubscription()
+{
+    if (!state_)
+        return;
+    {
+        Lock lock(state_->mutex());
+        state_->kill();
+        state_->clear();
+    }
+    State::releaseRef(state_);
+}
+
+template <class Threading>
+auto BasicSubscription<void(), Threading, VectorStorage, Ordered>::State::add(
+    internal::Callback<> callback, Priority priority, DisposableImpl* handle) -> Id
+{
+    const Id id = ++lastId;
+    if (notifying) {
+        pending.push_back(PendingEntry{priority, Entry{id, handle, std::move(callback)}});
+    } else {
+        thaw();
+        append(Entry{id, handle, std::move(callback)}, priority);
+    }
+    return id;
+}
+
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::State::append(
+    Entry&& entry, Priority priority)
+{
+    if (!bucketed && !single.id) {
+        single = std::move(entry);
+        singlePriority = priority;
+        return;
+    }
+    if (single.id) {
+        bucket(singlePriority).push_back(std::move(single));
+        single = Entry();
+        ++bucketed;
+    }
+    bucket(priority).push_back(std::move(entry));
+    ++bucketed;
+}
+
+template <class Threading>
+std::pmr::vector<typename BasicSubscription<void(), Threading, VectorStorage, Ordered>::Entry>&
+BasicSubscription<void(), Threading, VectorStorage, Ordered>::State::bucket(Priority priority)
+{
+    auto it = std::find_if(
+        buckets.begin(), buckets.end(), [priority](const Bucket& b) { return b.priority <= priority; });
+    if (it == buckets.end() || it->priority != priority)
+        it = buckets.insert(it, Bucket{priority, std::pmr::vector<Entry>(buckets.get_allocator())});
+    return it->entries;
+}
+
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::State::reserve(
+    size_t count, Priority priority)
+{
+    if (notifying) {
+        pending.reserve(pending.size() + count);
+        return;
+    }
+    thaw();
+    // The single callback is moved to a bucket by the second one
+    const size_t promoted = single.id ? 1 : 0;
+    if (bucketed + promoted + count < 2)
+        return;
+    auto& entries = bucket(priority);
+    entries.reserve(entries.size() + count + promoted);
+}
+
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::State::demote() noexcept
+{
+    if (bucketed != 1)
+        return;
+    for (Bucket& bucket : buckets) {
+        if (!bucket.entries.empty()) {
+            single = std::move(bucket.entries.front());
+            singlePriority = bucket.priority;
+            bucket.entries.clear();
+            bucketed = 0;
+            return;
+        }
+    }
+}
+
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::State::release(Id id) noexcept
+{
+    if (isFrozen) {
+        auto it = std::find_if(frozenEntries.begin(), frozenEntries.end(), [id](const FrozenEntry& e) {
+            return e.id == id;
+        });
+        if (it != frozenEntries.end()) {
+            frozen[it - frozenEntries.begin()].mute();
+            *it = FrozenEntry{0, nullptr, it->priority};
+            hasReleased = true;
+            if (!notifying)
+                clean();
+            return;
+        }
+    }
+    if (single.id == id) {
+        if (notifying) {
+            // The callback may be running, it is destroyed after notification
+            single.id = 0;
+            single.handle = nullptr;
+            hasReleased = true;
+        } else {
+            single = Entry();
+        }
+        return;
+    }
+    auto matches = [id](const Entry& e) { return e.id == id; };
+    for (Bucket& bucket : buckets) {
+        auto it = std::find_if(bucket.entries.begin(), bucket.entries.end(), matches);
+        if (it == bucket.entries.end())
+            continue;
+        if (notifying) {
+            // The callback may be running, it is destroyed after notification
+            it->id = 0;
+            it->handle = nullptr;
+            hasReleased = true;
+        } else {
+            bucket.entries.erase(it);
+            --bucketed;
+            demote();
+        }
+        return;
+    }
+    for (PendingEntry& pendingEntry : pending) {
+        if (pendingEntry.entry.id == id) {
+            pendingEntry.entry.id = 0;
+            pendingEntry.entry.handle = nullptr;
+            return;
+        }
+    }
+}
+
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::State::releaseSorted(
+    const internal::DisposablePtr* handles, size_t count) noexcept
+{
+    auto released = [handles, count](Id id) {
+        auto it = std::lower_bound(handles, handles + count, id, [](const auto& handle, Id id) {
+            return static_cast<const DisposableImpl&>(*handle).id() < id;
         });
-        assert(it != lock->end());
-        it->release();
+        return id && it != handles + count && static_cast<const DisposableImpl&>(**it).id() == id;
+    };
+    bool releasedFrozen = false;
+    for (size_t i = 0; i < frozenEntries.size(); ++i) {
+        if (released(frozenEntries[i].id)) {
+            frozen[i].mute();
+            frozenEntries[i] = FrozenEntry{0, nullptr, frozenEntries[i].priority};
+            releasedFrozen = hasReleased = true;
+        }
+    }
+    if (released(single.id)) {
+        if (notifying) {
+            // The callback may be running, it is destroyed after notification
+            single.id = 0;
+            single.handle = nullptr;
+            hasReleased = true;
+        } else {
+            single = Entry();
+        }
     }
-    callbacks_.reset();
-    identity_ = {};
+    for (Bucket& bucket : buckets) {
+        if (notifying) {
+            for (Entry& entry : bucket.entries) {
+                if (released(entry.id)) {
+                    entry.id = 0;
+                    entry.handle = nullptr;
+                    hasReleased = true;
+                }
+            }
+        } else {
+            auto end = std::remove_if(bucket.entries.begin(), bucket.entries.end(), [&](const Entry& e) {
+                return released(e.id);
+            });
+            bucketed -= bucket.entries.end() - end;
+            bucket.entries.erase(end, bucket.entries.end());
+        }
+    }
+    for (PendingEntry& pendingEntry : pending) {
+        if (released(pendingEntry.entry.id)) {
+            pendingEntry.entry.id = 0;
+            pendingEntry.entry.handle = nullptr;
+        }
+    }
+    if (!notifying) {
+        if (releasedFrozen)
+            clean();
+        else
+            demote();
+    }
+}
+
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::State::retire(Entry& entry) noexcept
+{
+    if (entry.handle)
+        entry.handle->detach();
+    entry.handle = nullptr;
+    entry.id = 0;
+    hasReleased = true;
+}
+
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::State::retireFrozen(
+    size_t index) noexcept
+{
+    // A nested notification must not call it again
+    frozen[index].mute();
+    FrozenEntry& entry = frozenEntries[index];
+    if (entry.handle)
+        entry.handle->detach();
+    entry = FrozenEntry{0, nullptr, entry.priority};
+    hasReleased = true;
 }
 
-void LambdaSubscription::notifyAll()
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::State::clean()
 {
-    for (size_t i = 0, size = callbacks_->size(); i < size; ++i)  // NOLINT(modernize-loop-convert)
-        callbacks_->at(i)();
+    if (isFrozen && (hasReleased || !pending.empty()))
+        thaw();
+    if (hasReleased) {
+        if (!single.id)
+            single = Entry();
+        for (Bucket& bucket : buckets) {
+            auto released = std::remove_if(
+                bucket.entries.begin(), bucket.entries.end(), [](const Entry& e) { return e.id == 0; });
+            bucketed -= bucket.entries.end() - released;
+            bucket.entries.erase(released, bucket.entries.end());
+        }
+        hasReleased = false;
+    }
+    if (!pending.empty()) {
+        for (PendingEntry& pendingEntry : pending) {
+            if (pendingEntry.entry.id)
+                append(std::move(pendingEntry.entry), pendingEntry.priority);
+        }
+        pending.clear();
+    }
+    demote();
+    // Compaction is amortized by at least as many bytes released since the previous one
+    if (arena.releasedBytes() > 0 && arena.releasedBytes() >= arena.liveBytes())
+        compactArena();
+}
 
-    callbacks_->erase(
-        std::remove_if(
-            callbacks_->begin(),
-            callbacks_->end(),
-            [](auto&& callable) { return callable.identity() == IdentityCallable::Identity(); }),
-        callbacks_->end());
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::State::compactArena()
+{
+    arena.beginCompaction();
+    single.callback.relocate();
+    for (Bucket& bucket : buckets) {
+        for (Entry& entry : bucket.entries)
+            entry.callback.relocate();
+    }
+    for (auto& callback : frozen)
+        callback.relocate();
+    arena.endCompaction();
 }
 
-}  // namespace subscriptions
\ No newline at end of file
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::State::freeze()
+{
+    if (isFrozen)
+        return;
+    clean();
+    if (single.id) {
+        frozen.push_back(std::move(single.callback));
+        frozenEntries.push_back(FrozenEntry{single.id, single.handle, singlePriority});
+        single = Entry();
+    }
+    frozen.reserve(bucketed);
+    frozenEntries.reserve(bucketed);
+    for (Bucket& bucket : buckets) {
+        for (Entry& entry : bucket.entries) {
+            frozen.push_back(std::move(entry.callback));
+            frozenEntries.push_back(FrozenEntry{entry.id, entry.handle, bucket.priority});
+        }
+    }
+    buckets.clear();
+    buckets.shrink_to_fit();
+    bucketed = 0;
+    compactArena();
+    isFrozen = true;
+}
+
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::State::clear() noexcept
+{
+    pending.clear();
+    frozen.clear();
+    frozenEntries.clear();
+    buckets.clear();
+    bucketed = 0;
+    single = Entry();
+}
+
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::State::thaw()
+{
+    if (!isFrozen)
+        return;
+    isFrozen = false;
+    for (size_t i = 0; i < frozen.size(); ++i) {
+        const FrozenEntry& entry = frozenEntries[i];
+        if (entry.id)
+            append(Entry{entry.id, entry.handle, std::move(frozen[i])}, entry.priority);
+    }
+    frozen.clear();
+    frozenEntries.clear();
+}
+
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::freeze()
+{
+    if (!state_)
+        return;
+    Lock lock(state_->mutex());
+    if (!state_->notifying)
+        state_->freeze();
+}
+
+template <class Threading>
+template <bool kStoppable>
+bool BasicSubscription<void(), Threading, VectorStorage, Ordered>::notify()
+{
+    if (!state_)
+        return false;
+    State& state = *state_;
+    Lock lock(state.mutex());
+    ++state.notifying;
+    // Ends the notification even if a callback throws.
+    // Nested notification does not stop the outer one.
+    struct Guard {
+        State& state;
+        const bool outerHandled;
+
+        ~Guard() noexcept(false)
+        {
+            state.handled = outerHandled;
+            if (--state.notifying == 0)
+                state.clean();
+        }
+    } guard{state, std::exchange(state.handled, false)};
+    if (state.isFrozen) {
+        for (size_t i = 0, size = state.frozen.size(); i < size; ++i) {
+            if (!state.frozen[i]())
+                state.retireFrozen(i);
+            if (kStoppable && state.handled)
+                break;
+        }
+    } else if (!state.bucketed) {
+        if (state.single.id && !state.single.callback())
+            state.retire(state.single);
+    } else {
+        // Buckets are not added during notification, callbacks subscribed to them are pending
+        for (Bucket& bucket : state.buckets) {
+            for (size_t i = 0, size = bucket.entries.size(); i < size; ++i) {
+                Entry& entry = bucket.entries[i];
+                if (entry.id && !entry.callback())
+                    state.retire(entry);
+                if (kStoppable && state.handled)
+                    break;
+            }
+            if (kStoppable && state.handled)
+                break;
+        }
+    }
+    return state.handled;
+}
+
+template <class Threading>
+void BasicSubscription<void(), Threading, VectorStorage, Ordered>::notifyAll()
+{
+    notify<false>();
+}
+
+template <class Threading>
+bool BasicSubscription<void(), Threading, VectorStorage, Ordered>::notifyUntilHandled()
+{
+    return notify<true>();
+}
+
+template class BasicSubscription<void(), SingleThreaded, VectorStorage, Ordered>;
+template class BasicSubscription<void(), MultiThreaded, VectorStorage, Ordered>;
+
+}  // namespace subscriptions
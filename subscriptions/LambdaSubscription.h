@@ -1,95 +1,549 @@
 #pragma once
+#include "aligned_allocator.h"
+#include "callback.h"
+#include "combiners.h"
 #include "disposable.h"
+#include "policies.h"
+#include "shared_state.h"
+#include "trackable.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <iterator>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace subscriptions {
 
-class LambdaSubscription final {
-  // Lambda type erase which can be identified
-  class IdentityCallable {
-  public:
-    class Identity {
-    public:
-      Identity() : pointer_(nullptr) {}
+// Callbacks without arguments notified by priority, and in subscription order within one,
+// with a single callback fast path and freeze().
+// Other signatures and policies are implemented in BasicSubscription.h.
+template <class Threading>
+class BasicSubscription<void(), Threading, VectorStorage, Ordered> final {
+public:
+  // Callbacks of higher priority are notified first
+  using Priority = int;
 
-      explicit Identity(void* pointer) : pointer_(pointer) {}
+private:
+  using Id = std::uint64_t;
 
-      bool operator==(const Identity& other) const { return pointer_ == other.pointer_; }
+  class DisposableImpl;
 
-      bool operator!=(const Identity& other) const { return !(*this == other); }
+  // Callback which can be identified, zero id means released one.
+  // The handle, if any, is detached when the callback asks for removal.
+  struct Entry {
+    Id id = 0;
+    DisposableImpl* handle = nullptr;
+    internal::Callback<> callback;
+  };
 
-    private:
-      void* pointer_;
-    };
+  // Callbacks of one priority, subscription appends to the end
+  struct Bucket {
+    Priority priority;
+    std::pmr::vector<Entry> entries;
+  };
 
-    template <class Func>
-    explicit IdentityCallable(Func func) : invoker_(new Derived<Func>(std::move(func)))
-    {
-      static_assert(std::is_invocable<Func>::value, "Only callable type allowed");
-    }
+  struct PendingEntry {
+    Priority priority;
+    Entry entry;
+  };
 
-    void operator()() const
+  using FrozenCallbacks =
+      std::vector<internal::Callback<>, internal::CacheLineAllocator<internal::Callback<>>>;
+
+  // Frozen callback's data, which is not needed by notification
+  struct FrozenEntry {
+    Id id;
+    DisposableImpl* handle;
+    Priority priority;
+  };
+
+  struct State final : internal::SharedState<State, Threading> {
+    explicit State(std::pmr::memory_resource* resource)
+        : internal::SharedState<State, Threading>(resource)
+        , arena(resource)
+        , buckets(resource)
+        , frozen(FrozenCallbacks::allocator_type(resource))
+        , frozenEntries(resource)
+        , pending(resource)
     {
-      if (invoker_)
-        invoker_->call();
     }
 
-    void release() { invoker_.reset(); }
+    // Memory of large callables, declared first to outlive them
+    internal::CallbackArena arena;
+    // The only callback, used while buckets are empty
+    Entry single;
+    Priority singlePriority = 0;
+    // Buckets in descending order of priority, empty ones are kept for reuse
+    std::pmr::vector<Bucket> buckets;
+    size_t bucketed = 0;
+    // Callbacks compacted by freeze() replace single and buckets,
+    // the rest of their entries is kept apart for unsubscription and thawing
+    FrozenCallbacks frozen;
+    std::pmr::vector<FrozenEntry> frozenEntries;
+    bool isFrozen = false;
+    // Callbacks subscribed during notification. Callbacks are kept in place,
+    // so buckets must not reallocate under a running one.
+    std::pmr::vector<PendingEntry> pending;
+    Id lastId = 0;
+    int notifying = 0;
+    bool hasReleased = false;
+    // Set by a callback returning Propagation::Stop during the innermost notification
+    bool handled = false;
+    // Memory of handles allocated alone. Freed handles are reused by the next ones,
+    // chunks are returned with the state, which every handle holds.
+    struct HandleChunk {
+      HandleChunk* next;
+      size_t count;
+    };
+    HandleChunk* handleChunks = nullptr;
+    void* freeHandles = nullptr;
 
-    [[nodiscard]] Identity identity() const { return Identity(invoker_.get()); }
+    ~State();
 
-  private:
-    struct Base {
-      virtual ~Base() = default;
+    Id add(internal::Callback<> callback, Priority priority, DisposableImpl* handle);
 
-      virtual void call() const = 0;
-    };
+    void append(Entry&& entry, Priority priority);
 
-    template <class Func>
-    struct Derived : Base {
-      const Func func_;
+    // Finds or inserts the bucket keeping buckets sorted
+    std::pmr::vector<Entry>& bucket(Priority priority);
 
-      explicit Derived(Func func) : func_(func) {}
+    // Prepares for adding count callbacks of the priority
+    void reserve(size_t count, Priority priority);
 
-      void call() const override { std::invoke(func_); }
-    };
+    void release(Id id) noexcept;
 
-  private:
-    std::unique_ptr<Base> invoker_;
+    // Releases callbacks of handles sorted by id in one pass over callbacks
+    void releaseSorted(const internal::DisposablePtr* handles, size_t count) noexcept;
+
+    // Removes the entry whose callback has asked for it during notification
+    void retire(Entry& entry) noexcept;
+
+    void retireFrozen(size_t index) noexcept;
+
+    void clean();
+
+    // Moves the last callback back into single
+    void demote() noexcept;
+
+    void freeze();
+
+    void thaw();
+
+    // Relocates callables allocated in the arena contiguously in notification order
+    void compactArena();
+
+    // Destroys callbacks of the dying subscription
+    void clear() noexcept;
+
+    void* allocateHandle();
+
+    void deallocateHandle(void* memory) noexcept;
   };
 
+  using Lock = std::lock_guard<typename Threading::Mutex>;
+
+  struct HandleBlock;
+
   class DisposableImpl final : public internal::Disposable {
   public:
-    DisposableImpl(
-        std::weak_ptr<std::vector<IdentityCallable>> callbacks,
-        IdentityCallable::Identity identity);
+    DisposableImpl(State* state, std::pmr::memory_resource* resource, HandleBlock* block = nullptr);
     ~DisposableImpl() override { dispose(); }
 
+    void destroy() noexcept override;
+
+    // Called under the state's lock
+    void attach(Id id) noexcept { id_ = id; }
+
+    void detach() noexcept { id_ = 0; }
+
+    [[nodiscard]] Id id() const noexcept { return id_; }
+
+    const void* batchKey() const noexcept override { return state_; }
+
+    void disposeBatch(internal::DisposablePtr* handles, size_t count) noexcept override;
+
   private:
     void dispose() noexcept;
 
-    friend class LambdaSubscription;
+    State* state_;
+    Id id_;
+    std::pmr::memory_resource* resource_;
+    // Null for a handle allocated alone in the state's pool
+    HandleBlock* block_;
+  };
+
+  // Header of handles allocated together, the last destroyed one frees the memory
+  struct HandleBlock {
+    HandleBlock(size_t count) : live(count), count(count) {}
 
-    std::weak_ptr<std::vector<IdentityCallable>> callbacks_;
-    IdentityCallable::Identity identity_;
+    // Constructs count handles following the header
+    static DisposableImpl* create(State* state, size_t count, std::pmr::memory_resource* resource);
+
+    static void release(HandleBlock* block, std::pmr::memory_resource* resource) noexcept;
+
+    static constexpr size_t kHandlesOffset =
+        (sizeof(HandleBlock) + alignof(DisposableImpl) - 1) / alignof(DisposableImpl) *
+        alignof(DisposableImpl);
+
+    typename Threading::Counter live;
+    size_t count;
+  };
+
+  // Connection of a trackable object, which owns it instead of a handle together with
+  // the callback. Disconnection only marks it, so it doesn't search for the callback,
+  // which asks for removal on the next notification.
+  class TrackedImpl final : public internal::TrackedConnection {
+  public:
+    TrackedImpl(State* state, std::pmr::memory_resource* resource) noexcept
+        : state_(state), resource_(resource)
+    {
+      state_->addRef();
+    }
+
+    ~TrackedImpl() { State::releaseRef(state_); }
+
+    void disconnect() noexcept override;
+
+    // Called under the state's lock
+    [[nodiscard]] bool connected() const noexcept { return connected_; }
+
+    [[nodiscard]] State* state() const noexcept { return state_; }
+
+    // Called under the state's lock by the destroyed callback
+    void release() noexcept;
+
+  private:
+    State* state_;
+    std::pmr::memory_resource* resource_;
+    // The object and the callback
+    int owners_ = 2;
+    bool connected_ = true;
+  };
+
+  // Callback of a trackable object, owning its connection with the object
+  template <auto Method, class T>
+  class Tracked {
+  public:
+    Tracked(T* object, TrackedImpl* connection) noexcept : object_(object), connection_(connection) {}
+
+    Tracked(Tracked&& other) noexcept
+        : object_(other.object_), connection_(std::exchange(other.connection_, nullptr))
+    {
+    }
+
+    Tracked& operator=(Tracked&&) = delete;
+
+    ~Tracked()
+    {
+      if (connection_)
+        connection_->release();
+    }
+
+    Retention operator()() const
+    {
+      if (!connection_->connected())
+        return Retention::Drop;
+      if constexpr (std::is_same_v<std::invoke_result_t<decltype(Method), T*>, Propagation>) {
+        if ((object_->*Method)() == Propagation::Stop)
+          connection_->state()->handled = true;
+      } else {
+        (object_->*Method)();
+      }
+      return Retention::Keep;
+    }
+
+  private:
+    T* object_;
+    TrackedImpl* connection_;
   };
 
 public:
+  // Shared state, callables and handles are allocated from the resource
+  explicit BasicSubscription(
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : resource_(resource)
+  {
+    // Concurrent subscription can't allocate the state lazily without a race
+    if constexpr (Threading::kConcurrent)
+      state_ = State::create(resource_);
+  }
+
+  BasicSubscription(BasicSubscription&& other) noexcept
+      : resource_(other.resource_), state_(std::exchange(other.state_, nullptr))
+  {
+  }
+
+  BasicSubscription& operator=(BasicSubscription&& other) noexcept
+  {
+    BasicSubscription subscription(std::move(other));
+    std::swap(resource_, subscription.resource_);
+    std::swap(state_, subscription.state_);
+    return *this;
+  }
+
+  ~BasicSubscription();
+
+  // Callback returning false or Retention::Drop is removed by the notification,
+  // then disposing its handle does nothing. Callback returning Propagation::Stop
+  // ends notifyUntilHandled.
+  template <class Callback>
+  [[nodiscard]] Disposable subscribe(Callback callback, Priority priority = 0)
+  {
+    static_assert(std::is_invocable<Callback>::value, "Only callable type allowed");
+    if (!state_)
+      state_ = State::create(resource_);
+    // Taken first, so the callback can't lose its handle
+    internal::DisposablePtr handle(newHandle());
+    add(std::move(callback), priority, static_cast<DisposableImpl*>(handle.get()));
+    return Disposable(std::move(handle));
+  }
+
+  // Subscribes a callback called at most count times. The notification removes it
+  // after the last call, without searching for it.
+  template <class Callback>
+  [[nodiscard]] Disposable subscribeN(size_t count, Callback callback, Priority priority = 0)
+  {
+    static_assert(std::is_invocable<Callback>::value, "Only callable type allowed");
+    if (count == 0)
+      return Disposable();
+    if (!state_)
+      state_ = State::create(resource_);
+    // Adapted inside the limit, so the count doesn't hide the callback's result
+    auto adapted = adapt(std::move(callback));
+    return subscribe(internal::Limited<decltype(adapted)>{std::move(adapted), count}, priority);
+  }
+
   template <class Callback>
-  [[nodiscard]] Disposable subscribe(Callback callback)
+  [[nodiscard]] Disposable subscribeOnce(Callback callback, Priority priority = 0)
+  {
+    return subscribeN(1, std::move(callback), priority);
+  }
+
+  // Subscribes every callback of the range with one reservation,
+  // the handles are allocated together
+  template <class Range>
+  [[nodiscard]] std::vector<Disposable> subscribeMany(Range&& callbacks, Priority priority = 0)
+  {
+    using Callback = std::decay_t<decltype(*std::begin(callbacks))>;
+    static_assert(std::is_invocable<Callback>::value, "Only callable type allowed");
+    std::vector<Disposable> disposables;
+    const size_t count = std::size(callbacks);
+    if (count == 0)
+      return disposables;
+    if (!state_)
+      state_ = State::create(resource_);
+    disposables.reserve(count);
+    DisposableImpl* handles = HandleBlock::create(state_, count, resource_);
+    for (size_t i = 0; i < count; ++i)
+      disposables.emplace_back(internal::DisposablePtr(handles + i));
+
+    Lock lock(state_->mutex());
+    state_->reserve(count, priority);
+    size_t i = 0;
+    for (auto&& callback : callbacks) {
+      internal::Callback<> erased =
+          std::is_lvalue_reference_v<Range> ? erase(Callback(callback)) : erase(std::move(callback));
+      handles[i].attach(state_->add(std::move(erased), priority, handles + i));
+      ++i;
+    }
+    return disposables;
+  }
+
+  // Returns a future which becomes ready at the next notification, or gets broken_promise
+  // if the subscription is destroyed before. No handle is allocated.
+  [[nodiscard]] std::future<void> nextNotification(Priority priority = 0)
+  {
+    std::promise<void> promise;
+    auto future = promise.get_future();
+    add(Fulfiller{std::move(promise)}, priority, nullptr);
+    return future;
+  }
+
+  // Subscribes a member function of the object. The object pointer with a statically bound call
+  // is kept in place of the callback, and the handle is reused from the state's pool,
+  // so resubscription doesn't allocate.
+  template <auto Method, class T>
+  [[nodiscard]] Disposable subscribe(T* object, Priority priority = 0)
+  {
+    static_assert(std::is_member_function_pointer_v<decltype(Method)>, "Method must be a member function");
+    return subscribe([object]() { return callMember<Method>(object); }, priority);
+  }
+
+  // Subscribes a member function of the trackable object until it is destroyed
+  // or disconnects all. The object owns the connection, so no handle is returned.
+  // Disconnection takes constant time, the callback is removed by the next notification.
+  template <auto Method, class T>
+  void subscribe(T& object, Priority priority = 0)
   {
-    IdentityCallable& c = callbacks_->emplace_back(std::move(callback));
-    return Disposable(std::make_unique<DisposableImpl>(callbacks_, c.identity()));
+    static_assert(std::is_member_function_pointer_v<decltype(Method)>, "Method must be a member function");
+    static_assert(std::is_base_of_v<Trackable, T>, "Object must derive from Trackable");
+    if (!state_)
+      state_ = State::create(resource_);
+    void* memory = resource_->allocate(sizeof(TrackedImpl), alignof(TrackedImpl));
+    auto* connection = new (memory) TrackedImpl(state_, resource_);
+    try {
+      add(Tracked<Method, T>(&object, connection), priority, nullptr);
+    } catch (...) {
+      // The callback has released its ownership
+      internal::destroyAllocated(connection, resource_);
+      throw;
+    }
+    static_cast<Trackable&>(object).track(*connection);
+  }
+
+  // Subscribes a member function of the observer while it is alive.
+  // The callback is removed during the first notification after the observer has expired.
+  template <auto Method, class T>
+  [[nodiscard]] Disposable subscribe(std::weak_ptr<T> observer, Priority priority = 0)
+  {
+    static_assert(std::is_member_function_pointer_v<decltype(Method)>, "Method must be a member function");
+    if constexpr (std::is_same_v<std::invoke_result_t<decltype(Method), T*>, Propagation>) {
+      if (!state_)
+        state_ = State::create(resource_);
+      return subscribe([observer = std::move(observer), state = state_]() {
+        const auto lock = observer.lock();
+        if (!lock)
+          return Retention::Drop;
+        if (((*lock).*Method)() == Propagation::Stop)
+          state->handled = true;
+        return Retention::Keep;
+      }, priority);
+    } else {
+      return subscribe([observer = std::move(observer)]() {
+        const auto lock = observer.lock();
+        if (!lock)
+          return Retention::Drop;
+        ((*lock).*Method)();
+        return Retention::Keep;
+      }, priority);
+    }
   }
 
   void notifyAll();
 
+  // Notifies callbacks until one returns Propagation::Stop, returns whether one did
+  bool notifyUntilHandled();
+
+  // Compacts callbacks into a cache line aligned array notified by a minimal loop.
+  // The next subscription or unsubscription thaws it. Has no effect during notification.
+  void freeze();
+
+  [[nodiscard]] bool frozen() const
+  {
+    if (!state_)
+      return false;
+    Lock lock(state_->mutex());
+    return state_->isFrozen;
+  }
+
 private:
-  std::shared_ptr<std::vector<IdentityCallable>> callbacks_ =
-      std::make_shared<std::vector<IdentityCallable>>();
+  struct Fulfiller {
+    Retention operator()() const
+    {
+      promise.set_value();
+      return Retention::Drop;
+    }
+
+    mutable std::promise<void> promise;
+  };
+
+  // Marks the notification handled when the callback returns Propagation::Stop
+  template <class Callback>
+  struct Handler {
+    void operator()() const
+    {
+      if (callback() == Propagation::Stop)
+        state->handled = true;
+    }
+
+    Callback callback;
+    State* state;
+  };
+
+  // Callback returning false asks to be removed
+  template <class Callback>
+  struct Retained {
+    Retention operator()() const
+    {
+      return callback() ? Retention::Keep : Retention::Drop;
+    }
+
+    Callback callback;
+  };
+
+  template <bool kStoppable>
+  bool notify();
+
+
+  // Other results than Propagation are ignored, so they don't remove the callback
+  template <auto Method, class T>
+  static auto callMember(T* object)
+  {
+    if constexpr (std::is_same_v<std::invoke_result_t<decltype(Method), T*>, Propagation>)
+      return (object->*Method)();
+    else
+      (object->*Method)();
+  }
+
+  // Turns Propagation and bool results into the handled flag and Retention,
+  // only callbacks of this subscription are removed by returning false. Needs the state.
+  template <class Callback>
+  auto adapt(Callback callback) const
+  {
+    using Result = std::invoke_result_t<const Callback&>;
+    if constexpr (std::is_same_v<Result, Propagation>)
+      return Handler<Callback>{std::move(callback), state_};
+    else if constexpr (std::is_same_v<Result, bool>)
+      return Retained<Callback>{std::move(callback)};
+    else
+      return callback;
+  }
+
+  // Called under the state's lock
+  template <class Callback>
+  internal::Callback<> erase(Callback callback)
+  {
+    return internal::Callback<>(adapt(std::move(callback)), &state_->arena);
+  }
+
+  // Constructs a handle in memory of the state's pool
+  DisposableImpl* newHandle()
+  {
+    void* memory;
+    {
+      Lock lock(state_->mutex());
+      memory = state_->allocateHandle();
+    }
+    return new (memory) DisposableImpl(state_, resource_);
+  }
+
+  template <class Callback>
+  Id add(Callback callback, Priority priority, DisposableImpl* handle)
+  {
+    if (!state_)
+      state_ = State::create(resource_);
+    Lock lock(state_->mutex());
+    const Id id = state_->add(erase(std::move(callback)), priority, handle);
+    if (handle)
+      handle->attach(id);
+    return id;
+  }
+
+  std::pmr::memory_resource* resource_;
+  // Allocated on the first subscription, shared with handles
+  State* state_ = nullptr;
 };
 
-}  // namespace yandex::maps::navikit::subscriptions
\ No newline at end of file
+template <class Threading>
+using BasicLambdaSubscription = BasicSubscription<void(), Threading>;
+
+using LambdaSubscription = BasicLambdaSubscription<SingleThreaded>;
+
+}  // namespace subscriptions
@@ -0,0 +1,126 @@
+#pragma once
+#include "BasicSubscription.h"
+#include "callback.h"
+#include "disposable.h"
+#include "policies.h"
+
+#include <chrono>
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace subscriptions {
+
+// Subscription keeping the last events, which a new callback receives on subscription
+// from the oldest one. Events are kept in a ring of slots allocated by the constructor,
+// so notification reuses them, and replay calls callbacks with the kept arguments.
+// Arguments are copied into the slots, so notification still allocates when copying
+// an owning argument, like a long std::string, does.
+template <class Threading, class Clock, class... Args>
+class BasicReplaySubscription final {
+  using Callbacks = BasicSubscription<void(Args...), Threading>;
+  using Lock = std::lock_guard<typename Threading::Mutex>;
+
+  struct Event {
+    typename Clock::time_point time;
+    std::tuple<std::decay_t<Args>...> arguments;
+  };
+
+public:
+  using Duration = typename Clock::duration;
+
+  // Replays at most capacity last events which are not older than the window
+  explicit BasicReplaySubscription(
+      std::size_t capacity,
+      Duration window = Duration::max(),
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : callbacks_(resource), events_(resource), capacity_(capacity), window_(window)
+  {
+    if (capacity == 0)
+      throw std::invalid_argument("Replay capacity must be positive");
+    events_.reserve(capacity);
+  }
+
+  // Calls the callback with kept events before subscribing it.
+  // Callback returning Retention::Drop stops the replay and is not subscribed,
+  // a bool result is ignored.
+  template <class Callback>
+  [[nodiscard]] Disposable subscribe(Callback callback)
+  {
+    static_assert(
+        std::is_invocable<Callback, const std::decay_t<Args>&...>::value, "Only callable type allowed");
+    Lock lock(callbacks_.state().mutex());
+    if (!replay(callback))
+      return Disposable();
+    return callbacks_.subscribe(std::move(callback));
+  }
+
+  void notifyAll(Args... args)
+  {
+    Lock lock(callbacks_.state().mutex());
+    record(args...);
+    callbacks_.notifyAll(std::forward<Args>(args)...);
+  }
+
+private:
+  void record(const std::decay_t<Args>&... args)
+  {
+    const auto now = this->now();
+    if (events_.size() < capacity_) {
+      events_.push_back(Event{now, {args...}});
+    } else {
+      Event& event = events_[next_];
+      event.time = now;
+      event.arguments = std::tie(args...);
+    }
+    next_ = (next_ + 1) % capacity_;
+  }
+
+  // Events are not timed without a window
+  typename Clock::time_point now() const
+  {
+    return window_ == Duration::max() ? typename Clock::time_point() : Clock::now();
+  }
+
+  // Returns false if the callback asks for removal
+  template <class Callback>
+  bool replay(const Callback& callback) const
+  {
+    const auto now = this->now();
+    auto replayRange = [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; ++i) {
+        const Event& event = events_[i];
+        if (now - event.time > window_)
+          continue;
+        const bool kept = std::apply(
+            [&callback](const auto&... arguments) {
+              return internal::invokeRetained(callback, arguments...);
+            },
+            event.arguments);
+        if (!kept)
+          return false;
+      }
+      return true;
+    };
+    // Until the ring is full the oldest event is the first one
+    const std::size_t oldest = events_.size() < capacity_ ? 0 : next_;
+    return replayRange(oldest, events_.size()) && replayRange(0, oldest);
+  }
+
+  Callbacks callbacks_;
+  // Guarded by the lock of callbacks' state
+  std::pmr::vector<Event> events_;
+  std::size_t next_ = 0;
+  std::size_t capacity_;
+  Duration window_;
+};
+
+template <class... Args>
+using ReplaySubscription = BasicReplaySubscription<SingleThreaded, std::chrono::steady_clock, Args...>;
+
+}  // namespace subscriptions
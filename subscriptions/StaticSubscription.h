@@ -0,0 +1,32 @@
+#pragma once
+
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace subscriptions {
+
+// Subscription with a fixed set of callbacks known at compile time.
+// There is no type erasure and no registration, notifyAll calls every callback
+// in order directly, so calls may be inlined.
+template <class... Funcs>
+class StaticSubscription final {
+public:
+  constexpr explicit StaticSubscription(Funcs... funcs) : funcs_(std::move(funcs)...) {}
+
+  template <class... Args>
+  constexpr void notifyAll(const Args&... args) const
+  {
+    static_assert((std::is_invocable_v<const Funcs&, const Args&...> && ...), "Callbacks must accept arguments");
+    std::apply([&](const Funcs&... funcs) { (std::invoke(funcs, args...), ...); }, funcs_);
+  }
+
+private:
+  std::tuple<Funcs...> funcs_;
+};
+
+template <class... Funcs>
+StaticSubscription(Funcs...) -> StaticSubscription<Funcs...>;
+
+}  // namespace subscriptions
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace subscriptions {
+namespace internal {
+
+constexpr std::size_t kCacheLineSize = 64;
+
+// Allocator placing arrays at the start of a cache line in memory of the resource
+template <class T>
+class CacheLineAllocator {
+public:
+  using value_type = T;
+
+  CacheLineAllocator() noexcept : resource_(std::pmr::get_default_resource()) {}
+
+  explicit CacheLineAllocator(std::pmr::memory_resource* resource) noexcept : resource_(resource) {}
+
+  template <class U>
+  CacheLineAllocator(const CacheLineAllocator<U>& other) noexcept : resource_(other.resource())
+  {
+  }
+
+  T* allocate(std::size_t n)
+  {
+    return static_cast<T*>(resource_->allocate(n * sizeof(T), kCacheLineSize));
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept
+  {
+    resource_->deallocate(p, n * sizeof(T), kCacheLineSize);
+  }
+
+  [[nodiscard]] std::pmr::memory_resource* resource() const { return resource_; }
+
+  template <class U>
+  bool operator==(const CacheLineAllocator<U>& other) const noexcept
+  {
+    return *resource_ == *other.resource();
+  }
+
+  template <class U>
+  bool operator!=(const CacheLineAllocator<U>& other) const noexcept { return !(*this == other); }
+
+private:
+  std::pmr::memory_resource* resource_;
+};
+
+}  // namespace internal
+}  // namespace subscriptions
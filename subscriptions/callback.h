@@ -0,0 +1,247 @@
+#pragma once
+#include "callback_arena.h"
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace subscriptions {
+
+// Result of a callback which decides whether it stays subscribed, Drop removes it
+enum class Retention : bool { Drop = false, Keep = true };
+
+namespace internal {
+
+// Calls func, returns false if it asks to be removed by returning Retention::Drop.
+// Any other result, bool included, is ignored.
+template <class Func, class... Args>
+bool invokeRetained(const Func& func, Args&&... args)
+{
+  using Result = std::invoke_result_t<const Func&, Args...>;
+  if constexpr (std::is_same_v<Result, Retention>) {
+    return std::invoke(func, std::forward<Args>(args)...) == Retention::Keep;
+  } else {
+    std::invoke(func, std::forward<Args>(args)...);
+    return true;
+  }
+}
+
+// Callable invoked at most remaining times, then asking for removal.
+// The call is counted before it is made, so a nested notification doesn't repeat the last one.
+template <class Func>
+struct Limited {
+  template <class... Args>
+  Retention operator()(Args&&... args) const
+  {
+    if (remaining == 0)
+      return Retention::Drop;
+    const bool last = --remaining == 0;
+    if (!invokeRetained(func, std::forward<Args>(args)...))
+      return Retention::Drop;
+    return last ? Retention::Drop : Retention::Keep;
+  }
+
+  Func func;
+  mutable std::size_t remaining;
+};
+
+// Type erased callable. Small nothrow movable callables, like lambdas capturing
+// a couple of pointers, are kept in place, others are allocated in the arena if it is given
+// or on the heap.
+template <class... Args>
+class Callback final {
+public:
+  Callback() = default;
+
+  template <class Func>
+  explicit Callback(Func func, CallbackArena* arena = nullptr)
+  {
+    static_assert(std::is_invocable<const Func&, Args...>::value, "Only callable type allowed");
+    if constexpr (kIsInline<Func>) {
+      new (storage_.buffer) Func(std::move(func));
+      if constexpr (!std::is_trivially_copyable_v<Func>)
+        manager_ = &manageInline<Func>;
+      invoker_ = &invokeInline<Func>;
+    } else if (arena) {
+      if constexpr (kFitsArena<Func>) {
+        storage_.external.pointer = new (arena->allocate(sizeof(Func))) Func(std::move(func));
+        manager_ = &manageArena<Func>;
+      } else {
+        // Not relocatable callables are allocated from the arena's memory resource
+        void* memory = arena->resource()->allocate(sizeof(Func), alignof(Func));
+        try {
+          storage_.external.pointer = new (memory) Func(std::move(func));
+        } catch (...) {
+          arena->resource()->deallocate(memory, sizeof(Func), alignof(Func));
+          throw;
+        }
+        manager_ = &manageResource<Func>;
+      }
+      storage_.external.arena = arena;
+      invoker_ = &invokeExternal<Func>;
+    } else {
+      storage_.external.pointer = new Func(std::move(func));
+      manager_ = &manageHeap<Func>;
+      invoker_ = &invokeExternal<Func>;
+    }
+  }
+
+  Callback(Callback&& other) noexcept { moveFrom(other); }
+
+  Callback& operator=(Callback&& other) noexcept
+  {
+    if (this != &other) {
+      reset();
+      moveFrom(other);
+    }
+    return *this;
+  }
+
+  Callback(const Callback&) = delete;
+
+  Callback& operator=(const Callback&) = delete;
+
+  ~Callback() { reset(); }
+
+  // Returns false if the callback asks to be removed
+  bool operator()(Args... args) const { return invoker_(storage_, std::forward<Args>(args)...); }
+
+  explicit operator bool() const { return invoker_ != nullptr; }
+
+  // Makes calls do nothing and ask for removal. Unlike reset, it is safe for a running callback,
+  // the callable is destroyed later.
+  void mute() noexcept
+  {
+    if (invoker_)
+      invoker_ = &invokeMuted;
+  }
+
+  // Moves the callable allocated in an arena to the arena's new chunk, see CallbackArena
+  void relocate() noexcept
+  {
+    if (manager_)
+      manager_(Operation::Relocate, storage_, nullptr);
+  }
+
+  void reset() noexcept
+  {
+    if (manager_)
+      manager_(Operation::Destroy, storage_, nullptr);
+    invoker_ = nullptr;
+    manager_ = nullptr;
+  }
+
+private:
+  union Storage {
+    struct {
+      void* pointer;
+      CallbackArena* arena;
+    } external;
+    alignas(void*) unsigned char buffer[2 * sizeof(void*)];
+  };
+
+  template <class Func>
+  static constexpr bool kIsInline = sizeof(Func) <= sizeof(Storage) &&
+                                    alignof(Func) <= alignof(Storage) &&
+                                    std::is_nothrow_move_constructible_v<Func>;
+
+  template <class Func>
+  static constexpr bool kFitsArena = alignof(Func) <= CallbackArena::kMaxAlignment &&
+                                     std::is_nothrow_move_constructible_v<Func>;
+
+  enum class Operation { Move, Relocate, Destroy };
+
+  using Invoker = bool (*)(const Storage&, Args...);
+  // Move constructs self from other and destroys other, relocates self or destroys self
+  using Manager = void (*)(Operation, Storage& self, Storage* other) noexcept;
+
+  static bool invokeMuted(const Storage&, Args...) { return false; }
+
+  template <class Func>
+  static bool invokeInline(const Storage& storage, Args... args)
+  {
+    return invokeRetained(
+        *std::launder(reinterpret_cast<const Func*>(storage.buffer)), std::forward<Args>(args)...);
+  }
+
+  template <class Func>
+  static bool invokeExternal(const Storage& storage, Args... args)
+  {
+    return invokeRetained(
+        *static_cast<const Func*>(storage.external.pointer), std::forward<Args>(args)...);
+  }
+
+  template <class Func>
+  static void manageInline(Operation operation, Storage& self, Storage* other) noexcept
+  {
+    if (operation == Operation::Move) {
+      auto* func = std::launder(reinterpret_cast<Func*>(other->buffer));
+      new (self.buffer) Func(std::move(*func));
+      func->~Func();
+    } else if (operation == Operation::Destroy) {
+      std::launder(reinterpret_cast<Func*>(self.buffer))->~Func();
+    }
+  }
+
+  template <class Func>
+  static void manageHeap(Operation operation, Storage& self, Storage* other) noexcept
+  {
+    if (operation == Operation::Move)
+      self.external = other->external;
+    else if (operation == Operation::Destroy)
+      delete static_cast<Func*>(self.external.pointer);
+  }
+
+  template <class Func>
+  static void manageResource(Operation operation, Storage& self, Storage* other) noexcept
+  {
+    if (operation == Operation::Move) {
+      self.external = other->external;
+    } else if (operation == Operation::Destroy) {
+      static_cast<Func*>(self.external.pointer)->~Func();
+      self.external.arena->resource()->deallocate(self.external.pointer, sizeof(Func), alignof(Func));
+    }
+  }
+
+  template <class Func>
+  static void manageArena(Operation operation, Storage& self, Storage* other) noexcept
+  {
+    switch (operation) {
+      case Operation::Move:
+        self.external = other->external;
+        break;
+      case Operation::Relocate: {
+        auto* func = static_cast<Func*>(self.external.pointer);
+        // Compaction has prepared a chunk for all live blocks, so allocation does not throw
+        void* memory = self.external.arena->allocate(sizeof(Func));
+        self.external.pointer = new (memory) Func(std::move(*func));
+        func->~Func();
+        break;
+      }
+      case Operation::Destroy:
+        static_cast<Func*>(self.external.pointer)->~Func();
+        self.external.arena->release(sizeof(Func));
+        break;
+    }
+  }
+
+  void moveFrom(Callback& other) noexcept
+  {
+    if (other.manager_)
+      other.manager_(Operation::Move, storage_, &other.storage_);
+    else
+      storage_ = other.storage_;
+    invoker_ = std::exchange(other.invoker_, nullptr);
+    manager_ = std::exchange(other.manager_, nullptr);
+  }
+
+  Storage storage_{};
+  Invoker invoker_ = nullptr;
+  // Null for callables which are kept in place and trivially copyable
+  Manager manager_ = nullptr;
+};
+
+}  // namespace internal
+}  // namespace subscriptions
@@ -0,0 +1,61 @@
+#include "callback_arena.h"
+
+#include <algorithm>
+
+namespace subscriptions::internal {
+
+namespace {
+constexpr std::size_t kMinChunkSize = 1024;
+}
+
+CallbackArena::~CallbackArena()
+{
+    free(chunks_);
+    free(retired_);
+}
+
+void* CallbackArena::allocate(std::size_t size)
+{
+    size = blockSize(size);
+    if (chunks_.empty() || chunks_.back().size - chunks_.back().used < size) {
+        const std::size_t last = chunks_.empty() ? 0 : chunks_.back().size;
+        addChunk(chunks_, std::max({kMinChunkSize, 2 * last, size}));
+    }
+    Chunk& chunk = chunks_.back();
+    void* block = chunk.data + chunk.used;
+    chunk.used += size;
+    used_ += size;
+    return block;
+}
+
+void CallbackArena::beginCompaction()
+{
+    std::pmr::vector<Chunk> chunks(resource());
+    if (const std::size_t live = liveBytes())
+        addChunk(chunks, live);
+    retired_.swap(chunks_);
+    chunks_.swap(chunks);
+    used_ = 0;
+    released_ = 0;
+}
+
+void CallbackArena::endCompaction() noexcept
+{
+    free(retired_);
+}
+
+void CallbackArena::addChunk(std::pmr::vector<Chunk>& chunks, std::size_t size)
+{
+    chunks.reserve(chunks.size() + 1);
+    auto* data = static_cast<std::byte*>(resource()->allocate(size, kMaxAlignment));
+    chunks.push_back(Chunk{data, size, 0});
+}
+
+void CallbackArena::free(std::pmr::vector<Chunk>& chunks) noexcept
+{
+    for (const Chunk& chunk : chunks)
+        resource()->deallocate(chunk.data, chunk.size, kMaxAlignment);
+    chunks.clear();
+}
+
+}  // namespace subscriptions::internal
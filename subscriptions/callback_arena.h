@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace subscriptions {
+namespace internal {
+
+// Memory for callables which do not fit into a callback. Blocks are allocated sequentially
+// and are never reused; compaction relocates live callables into one contiguous chunk.
+// Chunks are taken from the memory resource.
+class CallbackArena final {
+public:
+  // Largest alignment of a callable the arena accepts
+  static constexpr std::size_t kMaxAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+  explicit CallbackArena(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : chunks_(resource), retired_(resource)
+  {
+  }
+
+  CallbackArena(const CallbackArena&) = delete;
+
+  CallbackArena& operator=(const CallbackArena&) = delete;
+
+  ~CallbackArena();
+
+  [[nodiscard]] std::pmr::memory_resource* resource() const { return chunks_.get_allocator().resource(); }
+
+  // Blocks are aligned to kMaxAlignment, so compaction never needs padding
+  void* allocate(std::size_t size);
+
+  // Marks the block as garbage, the memory is returned by compaction
+  void release(std::size_t size) noexcept { released_ += blockSize(size); }
+
+  [[nodiscard]] std::size_t liveBytes() const { return used_ - released_; }
+
+  [[nodiscard]] std::size_t releasedBytes() const { return released_; }
+
+  // Retires current chunks and prepares one chunk for all live callables,
+  // which are then relocated by Callback::relocate
+  void beginCompaction();
+
+  // Frees retired chunks
+  void endCompaction() noexcept;
+
+private:
+  static std::size_t blockSize(std::size_t size)
+  {
+    return (size + kMaxAlignment - 1) / kMaxAlignment * kMaxAlignment;
+  }
+
+  struct Chunk {
+    std::byte* data;
+    std::size_t size;
+    std::size_t used;
+  };
+
+  void addChunk(std::pmr::vector<Chunk>& chunks, std::size_t size);
+
+  void free(std::pmr::vector<Chunk>& chunks) noexcept;
+
+  std::pmr::vector<Chunk> chunks_;
+  std::pmr::vector<Chunk> retired_;
+  std::size_t used_ = 0;
+  std::size_t released_ = 0;
+};
+
+}  // namespace internal
+}  // namespace subscriptions
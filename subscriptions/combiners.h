@@ -0,0 +1,119 @@
+#pragma once
+
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace subscriptions {
+
+// Combiners fold results of callbacks notified by notifyAll(combiner, ...) without storing them.
+// A combiner is called with every result and returns false to stop the notification,
+// or nothing to continue it. notifyAll returns what its result() does.
+
+// Whether every callback returns true, stops at the first false
+class AllOf {
+public:
+  bool operator()(bool value) noexcept
+  {
+    value_ = value;
+    return value;
+  }
+
+  [[nodiscard]] bool result() const noexcept { return value_; }
+
+private:
+  bool value_ = true;
+};
+
+// Whether any callback returns true, stops at the first true
+class AnyOf {
+public:
+  bool operator()(bool value) noexcept
+  {
+    value_ = value;
+    return !value;
+  }
+
+  [[nodiscard]] bool result() const noexcept { return value_; }
+
+private:
+  bool value_ = false;
+};
+
+template <class T>
+class Sum {
+public:
+  void operator()(const T& value) { sum_ += value; }
+
+  [[nodiscard]] T result() const { return sum_; }
+
+private:
+  T sum_{};
+};
+
+// Smallest result, none if no callback is notified
+template <class T>
+class Min {
+public:
+  void operator()(T value)
+  {
+    if (!min_ || value < *min_)
+      min_ = std::move(value);
+  }
+
+  [[nodiscard]] std::optional<T> result() const { return min_; }
+
+private:
+  std::optional<T> min_;
+};
+
+// Largest result, none if no callback is notified
+template <class T>
+class Max {
+public:
+  void operator()(T value)
+  {
+    if (!max_ || *max_ < value)
+      max_ = std::move(value);
+  }
+
+  [[nodiscard]] std::optional<T> result() const { return max_; }
+
+private:
+  std::optional<T> max_;
+};
+
+// Result of event handlers, Stop marks the event handled and skips the remaining handlers
+enum class Propagation : bool { Continue = false, Stop = true };
+
+// Whether a handler has handled the event, stops at it
+class Handled {
+public:
+  bool operator()(Propagation propagation) noexcept
+  {
+    handled_ = propagation == Propagation::Stop;
+    return !handled_;
+  }
+
+  [[nodiscard]] bool result() const noexcept { return handled_; }
+
+private:
+  bool handled_ = false;
+};
+
+namespace internal {
+
+// Passes the result to the combiner, returns false if it stops the notification
+template <class Combiner, class Result>
+bool combine(Combiner& combiner, Result&& result)
+{
+  if constexpr (std::is_void_v<decltype(combiner(std::forward<Result>(result)))>) {
+    combiner(std::forward<Result>(result));
+    return true;
+  } else {
+    return combiner(std::forward<Result>(result));
+  }
+}
+
+} // namespace internal
+} // namespace subscriptions
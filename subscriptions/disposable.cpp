@@ -0,0 +1,26 @@
+#include "disposable.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace subscriptions {
+
+void CompositeDisposable::dispose() noexcept
+{
+    // Handles of one subscription become adjacent
+    std::sort(disposables_.begin(), disposables_.end(), [](const auto& a, const auto& b) {
+        return std::less<const void*>()(a->batchKey(), b->batchKey());
+    });
+    for (size_t begin = 0; begin < disposables_.size();) {
+        const void* key = disposables_[begin]->batchKey();
+        size_t end = begin + 1;
+        while (end < disposables_.size() && disposables_[end]->batchKey() == key)
+            ++end;
+        if (key && end - begin > 1)
+            disposables_[begin]->disposeBatch(&disposables_[begin], end - begin);
+        begin = end;
+    }
+    disposables_.clear();
+}
+
+}  // namespace subscriptions
@@ -1,23 +1,75 @@
 #pragma once
-#pragma once
 
+#include <cstddef>
+#include <iterator>
 #include <memory>
+#include <memory_resource>
+#include <utility>
+#include <vector>
 
 namespace subscriptions {
 namespace internal {
 
+class Disposable;
+
+struct DisposableDeleter {
+  void operator()(Disposable* disposable) const noexcept;
+};
+
+using DisposablePtr = std::unique_ptr<Disposable, DisposableDeleter>;
+
 class Disposable {
 public:
   virtual ~Disposable() = default;
+
+  // Destroys the object and frees its memory, overridden by objects not allocated by new
+  virtual void destroy() noexcept { delete this; }
+
+  // Handles with the same non-null key belong to one subscription and can be disposed together
+  virtual const void* batchKey() const noexcept { return nullptr; }
+
+  // Disposes handles sharing the key of this one, which may be reordered.
+  // They are destroyed later and do nothing then.
+  virtual void disposeBatch(DisposablePtr* /*handles*/, std::size_t /*count*/) noexcept {}
 };
 
+inline void DisposableDeleter::operator()(Disposable* disposable) const noexcept
+{
+  disposable->destroy();
+}
+
+// Constructs Impl in memory of the resource, Impl::destroy must call destroyAllocated
+template <class Impl, class... Args>
+DisposablePtr allocateDisposable(std::pmr::memory_resource* resource, Args&&... args)
+{
+  void* memory = resource->allocate(sizeof(Impl), alignof(Impl));
+  try {
+    return DisposablePtr(new (memory) Impl(std::forward<Args>(args)...));
+  } catch (...) {
+    resource->deallocate(memory, sizeof(Impl), alignof(Impl));
+    throw;
+  }
+}
+
+template <class Impl>
+void destroyAllocated(Impl* impl, std::pmr::memory_resource* resource) noexcept
+{
+  impl->~Impl();
+  resource->deallocate(impl, sizeof(Impl), alignof(Impl));
+}
+
 } // namespace internal
 
+class CompositeDisposable;
+
 class Disposable final {
 public:
   Disposable() = default;
 
   explicit Disposable(std::unique_ptr<internal::Disposable> &&disposable)
+      : disposable_(disposable.release()) {}
+
+  explicit Disposable(internal::DisposablePtr &&disposable)
       : disposable_(std::move(disposable)) {}
 
   Disposable(const Disposable &) = delete;
@@ -39,6 +91,67 @@ public:
   }
 
 private:
-  std::unique_ptr<internal::Disposable> disposable_;
+  friend class CompositeDisposable;
+
+  internal::DisposablePtr disposable_;
 };
-}
\ No newline at end of file
+
+// Owns many handles, disposing them together visits each subscription once
+class CompositeDisposable final {
+public:
+  CompositeDisposable() = default;
+
+  CompositeDisposable(CompositeDisposable&&) noexcept = default;
+
+  CompositeDisposable& operator=(CompositeDisposable&& other) noexcept
+  {
+    CompositeDisposable disposables(std::move(other));
+    std::swap(disposables_, disposables.disposables_);
+    return *this;
+  }
+
+  ~CompositeDisposable() { dispose(); }
+
+  void reserve(std::size_t count) { disposables_.reserve(count); }
+
+  void add(Disposable&& disposable)
+  {
+    if (disposable.disposable_)
+      disposables_.push_back(std::move(disposable.disposable_));
+  }
+
+  CompositeDisposable& operator+=(Disposable&& disposable)
+  {
+    add(std::move(disposable));
+    return *this;
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept { return disposables_.size(); }
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return disposables_.capacity(); }
+
+  void dispose() noexcept;
+
+private:
+  std::vector<internal::DisposablePtr> disposables_;
+};
+
+// Disposes every handle of the range, handles of the same subscription are released in one pass
+template <class Range>
+void disposeMany(Range& disposables) noexcept
+{
+  CompositeDisposable composite;
+  try {
+    composite.reserve(std::size(disposables));
+  } catch (...) {
+    // Without memory the handles are disposed one by one
+  }
+  for (Disposable& disposable : disposables) {
+    if (composite.size() < composite.capacity())
+      composite.add(std::move(disposable));
+    else
+      disposable.dispose();
+  }
+  composite.dispose();
+}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "small_vector.h"
+#include "threading.h"
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace subscriptions {
+
+// Storage policies
+
+// Callbacks are kept in a vector, a handle finds its callback by a linear search
+struct VectorStorage {
+  static constexpr bool kIndexed = false;
+
+  template <class T>
+  using Container = std::pmr::vector<T>;
+};
+
+// Vector of callbacks with an index from handle keys to positions, so a handle finds its
+// callback in constant time. Keys of removed callbacks are reused.
+struct SlotMapStorage {
+  static constexpr bool kIndexed = true;
+
+  template <class T>
+  using Container = std::pmr::vector<T>;
+};
+
+// First N callbacks are kept in the shared state, so it is the only allocation for them
+template <std::size_t N>
+struct InlineStorage {
+  static constexpr bool kIndexed = false;
+
+  template <class T>
+  using Container = internal::SmallVector<T, N>;
+};
+
+// Ordering policies
+
+// Callbacks are notified in subscription order, removal shifts the following ones
+struct Ordered {
+  static constexpr bool kPreservesOrder = true;
+};
+
+// Notification order is unspecified, removal moves the last callback into the freed place
+struct Unordered {
+  static constexpr bool kPreservesOrder = false;
+};
+
+// Signature of subscriptions notifying members of Interface. Concretes are final listener
+// types which are kept apart, so notifyEach passes them by a statically known type.
+template <class Interface, class... Concretes>
+struct Listeners {};
+
+// Signature is a function type returning void or Listeners<Interface, Concretes...>.
+// Listeners support only VectorStorage.
+template <
+    class Signature,
+    class Threading = SingleThreaded,
+    class Storage = VectorStorage,
+    class Ordering = Ordered>
+class BasicSubscription;
+
+}  // namespace subscriptions
@@ -0,0 +1,62 @@
+#pragma once
+#include "disposable.h"
+
+#include <memory_resource>
+#include <mutex>
+#include <utility>
+
+namespace subscriptions {
+namespace internal {
+
+// Intrusively counted state shared by a subscription and its handles.
+// The subscription and every handle hold a reference. The subscription kills the state
+// when it is destroyed, after that handles do nothing, the last reference frees the memory.
+template <class Derived, class Threading>
+class SharedState {
+public:
+  using Mutex = typename Threading::Mutex;
+
+  template <class... Args>
+  static Derived* create(std::pmr::memory_resource* resource, Args&&... args)
+  {
+    void* memory = resource->allocate(sizeof(Derived), alignof(Derived));
+    try {
+      return new (memory) Derived(resource, std::forward<Args>(args)...);
+    } catch (...) {
+      resource->deallocate(memory, sizeof(Derived), alignof(Derived));
+      throw;
+    }
+  }
+
+  explicit SharedState(std::pmr::memory_resource* resource) : resource_(resource) {}
+
+  SharedState(const SharedState&) = delete;
+  SharedState& operator=(const SharedState&) = delete;
+
+  void addRef() noexcept { ++refs_; }
+
+  static void releaseRef(Derived* state) noexcept
+  {
+    if (--state->refs_ == 0)
+      destroyAllocated(state, state->resource_);
+  }
+
+  Mutex& mutex() noexcept { return mutex_; }
+
+  // Checked under the mutex by handles
+  [[nodiscard]] bool alive() const noexcept { return alive_; }
+
+  void kill() noexcept { alive_ = false; }
+
+protected:
+  ~SharedState() = default;
+
+private:
+  typename Threading::Counter refs_{1};
+  bool alive_ = true;
+  Mutex mutex_;
+  std::pmr::memory_resource* resource_;
+};
+
+}  // namespace internal
+}  // namespace subscriptions
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+namespace subscriptions {
+namespace internal {
+
+// Vector keeping first N default constructible elements in place,
+// others are spilled to memory of the resource
+template <class T, std::size_t N>
+class SmallVector {
+public:
+  explicit SmallVector(std::pmr::memory_resource* resource) : spill_(resource) {}
+
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+  T& operator[](std::size_t i) noexcept { return i < N ? inline_[i] : spill_[i - N]; }
+
+  const T& operator[](std::size_t i) const noexcept { return i < N ? inline_[i] : spill_[i - N]; }
+
+  T& back() noexcept { return (*this)[size_ - 1]; }
+
+  void reserve(std::size_t size)
+  {
+    if (size > N)
+      spill_.reserve(size - N);
+  }
+
+  void push_back(T&& value)
+  {
+    if (size_ < N)
+      inline_[size_] = std::move(value);
+    else
+      spill_.push_back(std::move(value));
+    ++size_;
+  }
+
+  void pop_back() noexcept
+  {
+    --size_;
+    if (size_ < N)
+      inline_[size_] = T();
+    else
+      spill_.pop_back();
+  }
+
+  void clear() noexcept
+  {
+    for (std::size_t i = 0; i < size_ && i < N; ++i)
+      inline_[i] = T();
+    spill_.clear();
+    size_ = 0;
+  }
+
+private:
+  std::array<T, N> inline_{};
+  std::pmr::vector<T> spill_;
+  std::size_t size_ = 0;
+};
+
+}  // namespace internal
+}  // namespace subscriptions
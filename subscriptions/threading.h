@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+namespace subscriptions {
+
+// Subscription used by one thread: plain counters and no locking
+struct SingleThreaded {
+  static constexpr bool kConcurrent = false;
+
+  using Counter = std::size_t;
+
+  struct Mutex {
+    void lock() noexcept {}
+    void unlock() noexcept {}
+    bool try_lock() noexcept { return true; }
+  };
+};
+
+// Subscription shared between threads: atomic counters and state guarded by a mutex,
+// which is recursive so callbacks may subscribe and dispose during notification.
+//
+// The mutex is held while callbacks run, by notification and by the replay of Behavior and
+// Replay subscriptions. A callback must not wait for a lock which another thread may hold while
+// it subscribes, disposes or notifies, otherwise the threads deadlock. Release such a lock
+// before disposing, or defer the callback's work to a queue.
+struct MultiThreaded {
+  static constexpr bool kConcurrent = true;
+
+  using Counter = std::atomic<std::size_t>;
+
+  using Mutex = std::recursive_mutex;
+};
+
+}  // namespace subscriptions
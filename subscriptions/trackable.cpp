@@ -0,0 +1,14 @@
+#include "trackable.h"
+
+namespace subscriptions {
+
+void Trackable::disconnectAll() noexcept
+{
+    // Unlinked first, so destroying a callback may subscribe the object again
+    while (internal::TrackedConnection* connection = connections_) {
+        connections_ = connection->next_;
+        connection->disconnect();
+    }
+}
+
+}  // namespace subscriptions
@@ -0,0 +1,54 @@
+#pragma once
+
+namespace subscriptions {
+
+class Trackable;
+
+namespace internal {
+
+// Connection owned by a trackable object, which disconnects it on destruction
+class TrackedConnection {
+public:
+  // Removes the callback and frees the connection
+  virtual void disconnect() noexcept = 0;
+
+protected:
+  ~TrackedConnection() = default;
+
+private:
+  friend class subscriptions::Trackable;
+
+  TrackedConnection* next_ = nullptr;
+};
+
+} // namespace internal
+
+// Base of objects whose member functions are subscribed without handles.
+// The object keeps an intrusive list of its connections and disconnects them on destruction,
+// so notification does not check the object's lifetime. Copies have no connections.
+// Connections of one object must not be made or disconnected concurrently.
+class Trackable {
+public:
+  Trackable(const Trackable&) noexcept {}
+
+  Trackable& operator=(const Trackable&) noexcept { return *this; }
+
+  // Links the connection, called by subscriptions
+  void track(internal::TrackedConnection& connection) noexcept
+  {
+    connection.next_ = connections_;
+    connections_ = &connection;
+  }
+
+  void disconnectAll() noexcept;
+
+protected:
+  Trackable() = default;
+
+  ~Trackable() { disconnectAll(); }
+
+private:
+  internal::TrackedConnection* connections_ = nullptr;
+};
+
+} // namespace subscriptions
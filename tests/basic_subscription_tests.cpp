@@ -0,0 +1,355 @@
+#include "doctest.h"
+
+#include "subscriptions/BasicSubscription.h"
+
+#include "counting_resource.h"
+
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+using namespace subscriptions;
+
+namespace {
+template <class Threading, class Storage, class Ordering>
+using IntSubscription = BasicSubscription<void(int), Threading, Storage, Ordering>;
+
+template <class Threading>
+using PolicyCombinations = std::tuple<
+    IntSubscription<Threading, VectorStorage, Ordered>,
+    IntSubscription<Threading, VectorStorage, Unordered>,
+    IntSubscription<Threading, SlotMapStorage, Ordered>,
+    IntSubscription<Threading, SlotMapStorage, Unordered>,
+    IntSubscription<Threading, InlineStorage<2>, Ordered>,
+    IntSubscription<Threading, InlineStorage<2>, Unordered>>;
+
+template <class Subscription>
+constexpr bool kOrdered = false;
+
+template <class Threading, class Storage>
+constexpr bool kOrdered<IntSubscription<Threading, Storage, Ordered>> = true;
+
+// Unordered subscriptions are compared as sets
+template <class Subscription>
+std::vector<int> normalized(std::vector<int> calls)
+{
+    if (!kOrdered<Subscription>)
+        std::sort(calls.begin(), calls.end());
+    return calls;
+}
+
+struct Counter {
+    void add(int value) { count += value; }
+
+    int count = 0;
+};
+}
+
+TEST_SUITE("BasicSubscription") {
+
+    TEST_CASE_TEMPLATE_DEFINE("NotifyAll", Subscription, notify_all)
+    {
+        Subscription subscription;
+        std::vector<int> calls;
+        std::vector<Disposable> disposables;
+        auto subscribeIndex = [&](int index) {
+            disposables.push_back(subscription.subscribe([&calls, index](int value) {
+                calls.push_back(index * 100 + value);
+            }));
+        };
+
+        SUBCASE("notifyAll does nothing for empty class") {
+            REQUIRE_NOTHROW(subscription.notifyAll(1));
+        }
+
+        SUBCASE("notifyAll passes arguments to every callback") {
+            for (int i = 0; i < 5; ++i)
+                subscribeIndex(i);
+            subscription.notifyAll(7);
+            REQUIRE_EQ(std::vector<int>{7, 107, 207, 307, 407}, normalized<Subscription>(calls));
+
+            SUBCASE("unsubscription removes callbacks") {
+                calls.clear();
+                disposables[0].dispose();
+                disposables[3].dispose();
+                subscription.notifyAll(1);
+                REQUIRE_EQ(std::vector<int>{101, 201, 401}, normalized<Subscription>(calls));
+
+                SUBCASE("and their places are reused") {
+                    calls.clear();
+                    subscribeIndex(5);
+                    subscribeIndex(6);
+                    disposables[1].dispose();
+                    subscription.notifyAll(1);
+                    REQUIRE_EQ(std::vector<int>{201, 401, 501, 601}, normalized<Subscription>(calls));
+                }
+            }
+        }
+
+        SUBCASE("unsubscription during a call") {
+            Disposable disposable;
+            disposables.push_back(subscription.subscribe([&](int value) {
+                calls.push_back(value);
+                disposable.dispose();
+            }));
+            disposable = subscription.subscribe([&](int value) { calls.push_back(value + 100); });
+            subscribeIndex(2);
+            subscription.notifyAll(1);
+            subscription.notifyAll(2);
+            const auto expected = kOrdered<Subscription> ? std::vector<int>{1, 201, 2, 202}
+                                                         : std::vector<int>{1, 2, 201, 202};
+            REQUIRE_EQ(expected, normalized<Subscription>(calls));
+        }
+
+        SUBCASE("subscription during a call is notified next time") {
+            disposables.push_back(subscription.subscribe([&](int value) {
+                calls.push_back(value);
+                if (disposables.size() < 4)
+                    subscribeIndex(static_cast<int>(disposables.size()));
+            }));
+            subscription.notifyAll(1);
+            REQUIRE_EQ(std::vector<int>{1}, calls);
+
+            calls.clear();
+            subscription.notifyAll(2);
+            REQUIRE_EQ(std::vector<int>{2, 102}, normalized<Subscription>(calls));
+
+            calls.clear();
+            disposables.front().dispose();
+            subscription.notifyAll(3);
+            REQUIRE_EQ(std::vector<int>{103, 203}, normalized<Subscription>(calls));
+        }
+    }
+    TEST_CASE_TEMPLATE_APPLY(notify_all, PolicyCombinations<SingleThreaded>);
+    TEST_CASE_TEMPLATE_APPLY(notify_all, PolicyCombinations<MultiThreaded>);
+
+    TEST_CASE_TEMPLATE_DEFINE("Churn during notification", Subscription, churn)
+    {
+        constexpr int kHandles = 32;
+        Subscription subscription;
+        std::vector<Disposable> disposables(kHandles);
+        std::vector<bool> live(kHandles);
+        std::vector<int> calls;
+        auto subscribeAt = [&](int i) {
+            disposables[i] = subscription.subscribe([&calls, i](int) { calls.push_back(i); });
+            live[i] = true;
+        };
+        for (int i = 0; i < kHandles; i += 2)
+            subscribeAt(i);
+
+        bool churning = false;
+        unsigned seed = 1;
+        auto driver = subscription.subscribe([&](int) {
+            for (int n = 0; churning && n < 4; ++n) {
+                seed = seed * 1103515245 + 12345;
+                const int i = static_cast<int>((seed >> 16) % kHandles);
+                if (live[i]) {
+                    disposables[i].dispose();
+                    live[i] = false;
+                } else {
+                    subscribeAt(i);
+                }
+            }
+        });
+
+        for (int round = 0; round < 50; ++round) {
+            churning = true;
+            subscription.notifyAll(0);
+            churning = false;
+
+            calls.clear();
+            subscription.notifyAll(0);
+            std::sort(calls.begin(), calls.end());
+            std::vector<int> expected;
+            for (int i = 0; i < kHandles; ++i) {
+                if (live[i])
+                    expected.push_back(i);
+            }
+            REQUIRE_EQ(expected, calls);
+        }
+    }
+    TEST_CASE_TEMPLATE_APPLY(churn, PolicyCombinations<SingleThreaded>);
+
+    TEST_CASE_TEMPLATE_DEFINE("Throwing callback", Subscription, throwing_callback)
+    {
+        Subscription subscription;
+        std::vector<int> calls;
+        Disposable nested;
+        auto first = subscription.subscribe([&calls](int value) { calls.push_back(value); });
+        auto thrower = subscription.subscribe([&](int) {
+            nested = subscription.subscribe([&calls](int value) { calls.push_back(10 * value); });
+            first.dispose();
+            throw std::runtime_error("callback");
+        });
+        REQUIRE_THROWS_AS(subscription.notifyAll(1), std::runtime_error);
+        thrower.dispose();
+
+        auto late = subscription.subscribe([&calls](int value) { calls.push_back(100 * value); });
+        subscription.notifyAll(2);
+        REQUIRE_EQ(std::vector<int>{1, 20, 200}, normalized<Subscription>(calls));
+    }
+    TEST_CASE_TEMPLATE_APPLY(throwing_callback, PolicyCombinations<SingleThreaded>);
+
+    TEST_CASE_TEMPLATE_DEFINE("Member subscription", Subscription, member_subscription)
+    {
+        Subscription subscription;
+        Counter counter;
+        auto counterShared = std::make_shared<Counter>();
+        auto disposable = subscription.template subscribe<&Counter::add>(&counter);
+        auto weakDisposable =
+            subscription.template subscribe<&Counter::add>(std::weak_ptr<Counter>(counterShared));
+        subscription.notifyAll(2);
+        REQUIRE_EQ(2, counter.count);
+        REQUIRE_EQ(2, counterShared->count);
+
+        counterShared.reset();
+        subscription.notifyAll(3);
+        REQUIRE_EQ(5, counter.count);
+    }
+    TEST_CASE_TEMPLATE_APPLY(member_subscription, PolicyCombinations<SingleThreaded>);
+
+    TEST_CASE_TEMPLATE_DEFINE("Callbacks returning bool stay subscribed", Subscription, bool_results)
+    {
+        Subscription subscription;
+        std::set<int> seen;
+        int calls = 0;
+        auto disposable = subscription.subscribe([&](int value) {
+            ++calls;
+            return seen.insert(value).second;
+        });
+        for (int i = 0; i < 3; ++i)
+            subscription.notifyAll(1);
+        REQUIRE_EQ(3, calls);
+    }
+    TEST_CASE_TEMPLATE_APPLY(bool_results, PolicyCombinations<SingleThreaded>);
+
+    TEST_CASE_TEMPLATE_DEFINE("Memory resource", Subscription, memory_resource)
+    {
+        CountingResource resource;
+        int sum = 0;
+        {
+            std::vector<Disposable> disposables;
+            {
+                Subscription subscription(&resource);
+                for (int i = 0; i < 10; ++i)
+                    disposables.push_back(subscription.subscribe([&sum](int value) { sum += value; }));
+                disposables[4].dispose();
+                subscription.notifyAll(1);
+                REQUIRE_EQ(9, sum);
+            }
+            // Handles outlive the subscription and keep its state
+            REQUIRE_GT(resource.outstanding, 0);
+        }
+        REQUIRE_EQ(0, resource.outstanding);
+    }
+    TEST_CASE_TEMPLATE_APPLY(memory_resource, PolicyCombinations<SingleThreaded>);
+    TEST_CASE_TEMPLATE_APPLY(memory_resource, PolicyCombinations<MultiThreaded>);
+
+    TEST_CASE("Callbacks without arguments")
+    {
+        BasicSubscription<void(), SingleThreaded, SlotMapStorage, Unordered> subscription;
+        int count = 0;
+        auto disposable1 = subscription.subscribe([&count]() { ++count; });
+        auto disposable2 = subscription.subscribe([&count]() { count += 10; });
+        disposable1.dispose();
+        subscription.notifyAll();
+        REQUIRE_EQ(10, count);
+    }
+
+    TEST_CASE("Callbacks returning values")
+    {
+        BasicSubscription<int(int)> subscription;
+        std::vector<int> calls;
+        auto subscribeFactor = [&](int factor) {
+            return subscription.subscribe([&calls, factor](int value) {
+                calls.push_back(factor);
+                return factor * value;
+            });
+        };
+
+        SUBCASE("without callbacks") {
+            CHECK_EQ(0, subscription.notifyAll(Sum<int>(), 1));
+            CHECK_FALSE(subscription.notifyAll(Max<int>(), 1).has_value());
+        }
+
+        auto disposable1 = subscribeFactor(1);
+        auto disposable2 = subscribeFactor(-2);
+        auto disposable3 = subscribeFactor(3);
+
+        SUBCASE("are folded") {
+            CHECK_EQ(4, subscription.notifyAll(Sum<int>(), 2));
+            CHECK_EQ(-4, subscription.notifyAll(Min<int>(), 2));
+            CHECK_EQ(6, subscription.notifyAll(Max<int>(), 2));
+            disposable3.dispose();
+            CHECK_EQ(-2, subscription.notifyAll(Sum<int>(), 2));
+        }
+
+        SUBCASE("by a custom combiner which stops the notification") {
+            struct FirstNegative {
+                bool operator()(int value)
+                {
+                    if (value < 0)
+                        found = value;
+                    return value >= 0;
+                }
+
+                int result() const { return found; }
+
+                int found = 0;
+            };
+            CHECK_EQ(-10, subscription.notifyAll(FirstNegative(), 5));
+            CHECK_EQ(std::vector<int>{1, -2}, calls);
+        }
+
+        SUBCASE("of expired observers are skipped") {
+            struct Voter {
+                int vote(int value) { return value; }
+            };
+            auto voter = std::make_shared<Voter>();
+            auto voterDisposable = subscription.subscribe<&Voter::vote>(std::weak_ptr<Voter>(voter));
+            CHECK_EQ(6, subscription.notifyAll(Sum<int>(), 2));
+            voter.reset();
+            CHECK_EQ(2, subscription.notifyAll(Sum<int>(), 1));
+        }
+    }
+
+    TEST_CASE("Callbacks returning bool are voters")
+    {
+        BasicSubscription<bool(), MultiThreaded, SlotMapStorage, Unordered> subscription;
+        int calls = 0;
+        auto yes = subscription.subscribe([&calls]() {
+            ++calls;
+            return true;
+        });
+        CHECK(subscription.notifyAll(AllOf()));
+        auto no = subscription.subscribe([&calls]() {
+            ++calls;
+            return false;
+        });
+        CHECK_FALSE(subscription.notifyAll(AllOf()));
+        CHECK(subscription.notifyAll(AnyOf()));
+        // Returning false does not remove the callback
+        CHECK_FALSE(subscription.notifyAll(AllOf()));
+        CHECK_EQ(6, calls);
+    }
+
+    TEST_CASE("Consumable events")
+    {
+        BasicSubscription<Propagation(int)> subscription;
+        std::vector<int> calls;
+        std::vector<Disposable> disposables;
+        for (int key = 0; key < 3; ++key) {
+            disposables.push_back(subscription.subscribe([&calls, key](int pressed) {
+                calls.push_back(key);
+                return pressed == key ? Propagation::Stop : Propagation::Continue;
+            }));
+        }
+        CHECK(subscription.notifyUntilHandled(1));
+        CHECK_EQ(std::vector<int>{0, 1}, calls);
+        CHECK_FALSE(subscription.notifyUntilHandled(5));
+        CHECK_EQ(std::vector<int>{0, 1, 0, 1, 2}, calls);
+    }
+}
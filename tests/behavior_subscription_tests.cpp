@@ -0,0 +1,154 @@
+#include "doctest.h"
+
+#include "subscriptions/BehaviorSubscription.h"
+
+#include "counting_resource.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace subscriptions;
+
+namespace {
+struct Recorder {
+    void record(const int& value) { values.push_back(value); }
+
+    std::vector<int> values;
+};
+}
+
+TEST_SUITE("BehaviorSubscription") {
+
+    TEST_CASE("Delivers the last value on subscription")
+    {
+        BehaviorSubscription<std::string> subscription;
+        std::vector<std::string> received;
+        auto callback = [&received](const std::string& value) { received.push_back(value); };
+
+        SUBCASE("nothing before the first notification") {
+            REQUIRE_FALSE(subscription.value());
+            auto disposable = subscription.subscribe(callback);
+            REQUIRE(received.empty());
+            subscription.notifyAll("a");
+            REQUIRE_EQ(std::vector<std::string>{"a"}, received);
+        }
+
+        SUBCASE("the last notified value") {
+            subscription.notifyAll("a");
+            subscription.notifyAll("b");
+            auto disposable = subscription.subscribe(callback);
+            REQUIRE_EQ(std::vector<std::string>{"b"}, received);
+            subscription.notifyAll("c");
+            REQUIRE_EQ(std::vector<std::string>{"b", "c"}, received);
+            REQUIRE_EQ("c", subscription.value());
+
+            SUBCASE("unsubscribed callback is not notified") {
+                disposable.dispose();
+                subscription.notifyAll("d");
+                REQUIRE_EQ(std::vector<std::string>{"b", "c"}, received);
+            }
+        }
+
+        SUBCASE("the initial value") {
+            BehaviorSubscription<std::string> initialized("initial");
+            auto disposable = initialized.subscribe(callback);
+            REQUIRE_EQ(std::vector<std::string>{"initial"}, received);
+        }
+
+        SUBCASE("callback refusing the value is not subscribed") {
+            subscription.notifyAll("a");
+            int calls = 0;
+            auto disposable = subscription.subscribe([&calls](const std::string&) {
+                ++calls;
+                return Retention::Drop;
+            });
+            subscription.notifyAll("b");
+            REQUIRE_EQ(1, calls);
+        }
+
+        SUBCASE("callback returning bool stays subscribed") {
+            subscription.notifyAll("a");
+            int calls = 0;
+            auto disposable = subscription.subscribe([&calls](const std::string&) {
+                ++calls;
+                return false;
+            });
+            subscription.notifyAll("b");
+            REQUIRE_EQ(2, calls);
+        }
+    }
+
+    TEST_CASE("Nested notification")
+    {
+        BehaviorSubscription<std::string> subscription;
+        std::vector<std::string> received;
+        auto renotifier = subscription.subscribe([&subscription](const std::string& value) {
+            if (value == "first")
+                subscription.notifyAll("nested");
+        });
+        auto disposable =
+            subscription.subscribe([&received](const std::string& value) { received.push_back(value); });
+        subscription.notifyAll("first");
+        REQUIRE_EQ(std::vector<std::string>{"nested", "first"}, received);
+        REQUIRE_EQ("nested", subscription.value());
+    }
+
+    TEST_CASE("Member subscription")
+    {
+        BehaviorSubscription<int> subscription(1);
+        Recorder recorder;
+        auto disposable = subscription.subscribe<&Recorder::record>(&recorder);
+        subscription.notifyAll(2);
+        REQUIRE_EQ(std::vector<int>{1, 2}, recorder.values);
+    }
+
+    TEST_CASE("Memory resource")
+    {
+        CountingResource resource;
+        {
+            BehaviorSubscription<int> subscription(1, &resource);
+            int sum = 0;
+            auto disposable = subscription.subscribe([&sum](int value) { sum += value; });
+            subscription.notifyAll(2);
+            REQUIRE_EQ(3, sum);
+            REQUIRE_GT(resource.allocations, 0);
+        }
+        REQUIRE_EQ(0, resource.outstanding);
+    }
+
+    TEST_CASE("Concurrent subscription receives values in order")
+    {
+        BasicBehaviorSubscription<MultiThreaded, int> subscription(0);
+        constexpr int kLast = 2000;
+        std::atomic<bool> ordered{true};
+
+        std::thread producer([&subscription]() {
+            for (int i = 1; i <= kLast; ++i)
+                subscription.notifyAll(i);
+        });
+        std::vector<std::thread> consumers;
+        for (int t = 0; t < 3; ++t) {
+            consumers.emplace_back([&subscription, &ordered]() {
+                for (int i = 0; i < 100; ++i) {
+                    int last = -1;
+                    auto disposable = subscription.subscribe([&last, &ordered](int value) {
+                        // Every value after the first one is the next one
+                        if (last >= 0 && value != last + 1)
+                            ordered = false;
+                        last = value;
+                    });
+                    if (last < 0)
+                        ordered = false;
+                }
+            });
+        }
+        producer.join();
+        for (auto& consumer : consumers)
+            consumer.join();
+
+        REQUIRE(ordered);
+        REQUIRE_EQ(kLast, subscription.value());
+    }
+}
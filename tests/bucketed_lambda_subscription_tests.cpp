@@ -0,0 +1,152 @@
+#include "doctest.h"
+
+#include "subscriptions/BucketedLambdaSubscription.h"
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace subscriptions;
+
+TEST_SUITE("BucketedLambdaSubscription") {
+
+    TEST_CASE ("NotifyAll")
+    {
+        BucketedLambdaSubscription subscription;
+        int invoke_count = 0;
+        auto callback = [&]() { ++invoke_count; };
+
+        SUBCASE("notifyAll does nothing for empty class") {
+            REQUIRE_NOTHROW(subscription.notifyAll());
+        }
+
+        SUBCASE("notifyAll for callbacks of different types") {
+            int other_count = 0;
+            auto disposable1 = subscription.subscribe(callback);
+            auto disposable2 = subscription.subscribe([&]() { ++other_count; });
+            auto disposable3 = subscription.subscribe(callback);
+            subscription.notifyAll();
+            REQUIRE_EQ(2, invoke_count);
+            REQUIRE_EQ(1, other_count);
+        }
+
+        SUBCASE("callbacks are grouped by type") {
+            std::vector<int> order;
+            auto first = [&]() { order.push_back(1); };
+            auto second = [&]() { order.push_back(2); };
+            auto disposable1 = subscription.subscribe(first);
+            auto disposable2 = subscription.subscribe(second);
+            auto disposable3 = subscription.subscribe(first);
+            subscription.notifyAll();
+            REQUIRE_EQ(std::vector<int>{1, 1, 2}, order);
+        }
+
+        SUBCASE("notifyAll for unsubscribed callback") {
+            auto disposable1 = subscription.subscribe(callback);
+            auto disposable2 = subscription.subscribe(callback);
+            auto disposable3 = subscription.subscribe(callback);
+            disposable2.dispose();
+            subscription.notifyAll();
+            REQUIRE_EQ(2, invoke_count);
+            subscription.notifyAll();
+            REQUIRE_EQ(4, invoke_count);
+        }
+
+        SUBCASE("unsubscription during a call") {
+            Disposable disposable;
+            auto auto_dispose_callback = [&]()
+            {
+                ++invoke_count;
+                disposable.dispose();
+            };
+            SUBCASE("if oneself") {
+                disposable = subscription.subscribe(auto_dispose_callback);
+                subscription.notifyAll();
+                REQUIRE_EQ(1, invoke_count);
+                subscription.notifyAll();
+                REQUIRE_EQ(1, invoke_count);
+            }
+
+            SUBCASE("if after") {
+                auto disposable1 = subscription.subscribe(auto_dispose_callback);
+                disposable = subscription.subscribe(callback);
+                subscription.notifyAll();
+                REQUIRE_EQ(1, invoke_count);
+                subscription.notifyAll();
+                REQUIRE_EQ(2, invoke_count);
+            }
+        }
+    }
+
+    TEST_CASE ("Unsubscribe when subscription has passed away")
+    {
+        Disposable disposable;
+        {
+            BucketedLambdaSubscription subscription;
+            disposable = subscription.subscribe([]() {});
+        }
+        disposable.dispose();
+    }
+
+    TEST_CASE("Subscribe when notify")
+    {
+        BucketedLambdaSubscription subscription;
+        int counter = 0;
+        const int addedCount = 20;
+        std::vector<Disposable> disposable;
+        auto callback = [&](){ ++counter; };
+        auto callbackWhichMakesSubscription = [&](){
+            ++counter;
+            for(int i=0; i<addedCount; ++i)
+                disposable.push_back(subscription.subscribe(callback));
+        };
+        disposable.push_back(subscription.subscribe(callbackWhichMakesSubscription));
+        disposable.push_back(subscription.subscribe(callback));
+        int expectedCount = disposable.size();
+        subscription.notifyAll();
+        CHECK_EQ(expectedCount, counter);
+        REQUIRE_EQ(expectedCount + addedCount, disposable.size());
+
+        counter = 0;
+        disposable.pop_back();
+        subscription.notifyAll();
+        CHECK_EQ(expectedCount + addedCount - 1, counter);
+    }
+
+    TEST_CASE("Unsubscription outside notification destroys the callback")
+    {
+        BucketedLambdaSubscription subscription;
+        auto resource = std::make_shared<int>(0);
+        std::vector<int> calls;
+        std::vector<Disposable> disposables;
+        for (int i = 0; i < 3; ++i)
+            disposables.push_back(subscription.subscribe([resource, &calls, i]() { calls.push_back(i); }));
+        REQUIRE_EQ(4, resource.use_count());
+
+        disposables[1].dispose();
+        REQUIRE_EQ(3, resource.use_count());
+        for (int i = 0; i < 1000; ++i)
+            subscription.subscribe([resource, &calls]() { calls.push_back(-1); }).dispose();
+        REQUIRE_EQ(3, resource.use_count());
+
+        subscription.notifyAll();
+        REQUIRE_EQ(std::vector<int>{0, 2}, calls);
+    }
+
+    TEST_CASE("Throwing callback ends the notification")
+    {
+        BucketedLambdaSubscription subscription;
+        int calls = 0;
+        Disposable nested;
+        auto thrower = subscription.subscribe([&]() {
+            nested = subscription.subscribe([&calls]() { ++calls; });
+            throw std::runtime_error("callback");
+        });
+        REQUIRE_THROWS_AS(subscription.notifyAll(), std::runtime_error);
+        thrower.dispose();
+
+        auto late = subscription.subscribe([&calls]() { calls += 10; });
+        subscription.notifyAll();
+        REQUIRE_EQ(11, calls);
+    }
+}
@@ -1,8 +1,11 @@
 #include "subscriptions/ClassicSubscription.h"
 
+#include "counting_resource.h"
 #include "doctest.h"
 #include "fakeit.hpp"
 
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 struct IManyPropertiesListener
@@ -14,6 +17,63 @@ struct IManyPropertiesListener
     virtual void onYChanged() = 0;
 };
 
+struct CountingListener final : IManyPropertiesListener
+{
+    void onXChanged() override { ++xCount; }
+
+    void onYChanged() override { ++yCount; }
+
+    int xCount = 0;
+    int yCount = 0;
+};
+
+struct IVoter
+{
+    virtual ~IVoter() = default;
+
+    virtual bool canRebuild(int route) = 0;
+
+    virtual int cost() = 0;
+};
+
+struct Voter final : IVoter
+{
+    Voter(bool allowed, int price) : allowed(allowed), price(price) {}
+
+    bool canRebuild(int route) override
+    {
+        ++calls;
+        return allowed && route > 0;
+    }
+
+    int cost() override { return price; }
+
+    bool allowed;
+    int price;
+    int calls = 0;
+};
+
+struct IKeyHandler
+{
+    virtual ~IKeyHandler() = default;
+
+    virtual subscriptions::Propagation onKey(int key) = 0;
+};
+
+struct KeyHandler final : IKeyHandler
+{
+    explicit KeyHandler(int key) : key(key) {}
+
+    subscriptions::Propagation onKey(int pressed) override
+    {
+        ++calls;
+        return pressed == key ? subscriptions::Propagation::Stop : subscriptions::Propagation::Continue;
+    }
+
+    int key;
+    int calls = 0;
+};
+
 using namespace fakeit;
 using namespace subscriptions;
 
@@ -134,4 +194,233 @@ TEST_SUITE ("ClassicSubscription") {
                     CHECK_NOTHROW(VerifyNoOtherInvocations(listeners[i]));
         }
     }
-}
\ No newline at end of file
+
+    TEST_CASE("Interest in members")
+    {
+        ClassicSubscription<IManyPropertiesListener> subscription;
+        Mock<IManyPropertiesListener> xListener;
+        Mock<IManyPropertiesListener> allListener;
+        Fake(Method(xListener, onXChanged));
+        Fake(Method(allListener, onXChanged), Method(allListener, onYChanged));
+        auto xDisposable = subscription.subscribe(&xListener.get(), &IManyPropertiesListener::onXChanged);
+        auto allDisposable = subscription.subscribe(&allListener.get());
+
+        SUBCASE("Listener is notified about listed member") {
+            subscription.notifyAll(&IManyPropertiesListener::onXChanged);
+            CHECK_NOTHROW(Verify(Method(xListener, onXChanged)).Once());
+            CHECK_NOTHROW(Verify(Method(allListener, onXChanged)).Once());
+        }
+
+        SUBCASE("Listener is skipped for not listed member") {
+            subscription.notifyAll(&IManyPropertiesListener::onYChanged);
+            CHECK_NOTHROW(VerifyNoOtherInvocations(xListener));
+            CHECK_NOTHROW(Verify(Method(allListener, onYChanged)).Once());
+        }
+
+        SUBCASE("Listener with several listed members") {
+            Mock<IManyPropertiesListener> xyListener;
+            Fake(Method(xyListener, onXChanged), Method(xyListener, onYChanged));
+            auto xyDisposable = subscription.subscribe(
+                &xyListener.get(),
+                &IManyPropertiesListener::onXChanged,
+                &IManyPropertiesListener::onYChanged);
+            subscription.notifyAll(&IManyPropertiesListener::onXChanged);
+            subscription.notifyAll(&IManyPropertiesListener::onYChanged);
+            CHECK_NOTHROW(Verify(Method(xyListener, onXChanged)).Once());
+            CHECK_NOTHROW(Verify(Method(xyListener, onYChanged)).Once());
+        }
+    }
+
+    TEST_CASE("Listeners grouped by concrete type")
+    {
+        ClassicSubscription<IManyPropertiesListener, CountingListener> subscription;
+        CountingListener concrete;
+        Mock<IManyPropertiesListener> generic;
+        Fake(Method(generic, onXChanged));
+        auto concreteDisposable = subscription.subscribe(&concrete);
+        auto genericDisposable = subscription.subscribe(&generic.get());
+
+        SUBCASE("Both kinds of listeners are notified") {
+            subscription.notifyAll(&IManyPropertiesListener::onXChanged);
+            CHECK_EQ(1, concrete.xCount);
+            CHECK_NOTHROW(Verify(Method(generic, onXChanged)).Once());
+        }
+
+        SUBCASE("Subscription twice is not allowed through the base pointer") {
+            REQUIRE_THROWS(
+                (void)subscription.subscribe(static_cast<IManyPropertiesListener*>(&concrete)));
+        }
+
+        SUBCASE("Concrete listener is unsubscribed") {
+            concreteDisposable.dispose();
+            subscription.notifyAll(&IManyPropertiesListener::onXChanged);
+            CHECK_EQ(0, concrete.xCount);
+        }
+
+        SUBCASE("Concrete listener with listed members") {
+            CountingListener yOnly;
+            auto yDisposable = subscription.subscribe(&yOnly, &IManyPropertiesListener::onYChanged);
+            subscription.notifyAll(&IManyPropertiesListener::onXChanged);
+            CHECK_EQ(0, yOnly.xCount);
+            CHECK_EQ(1, concrete.xCount);
+        }
+
+        SUBCASE("Concrete listeners are passed by their type to notifyEach") {
+            CountingListener yOnly;
+            auto yDisposable = subscription.subscribe(&yOnly, &IManyPropertiesListener::onYChanged);
+            int concreteCalls = 0;
+            subscription.notifyEach(&IManyPropertiesListener::onXChanged, [&concreteCalls](auto* listener) {
+                if constexpr (std::is_same_v<decltype(listener), CountingListener*>)
+                    ++concreteCalls;
+                listener->onXChanged();
+            });
+            CHECK_EQ(1, concreteCalls);
+            CHECK_EQ(1, concrete.xCount);
+            CHECK_EQ(0, yOnly.xCount);
+            CHECK_NOTHROW(Verify(Method(generic, onXChanged)).Once());
+        }
+    }
+
+    TEST_CASE("Frozen subscription")
+    {
+        ClassicSubscription<IManyPropertiesListener> subscription;
+        CountingListener first;
+        CountingListener second;
+        auto firstDisposable = subscription.subscribe(&first);
+        auto secondDisposable = subscription.subscribe(&second);
+        firstDisposable.dispose();
+        subscription.freeze();
+        REQUIRE(subscription.frozen());
+
+        subscription.notifyAll(&IManyPropertiesListener::onXChanged);
+        CHECK_EQ(0, first.xCount);
+        CHECK_EQ(1, second.xCount);
+
+        secondDisposable.dispose();
+        REQUIRE_FALSE(subscription.frozen());
+        subscription.notifyAll(&IManyPropertiesListener::onXChanged);
+        CHECK_EQ(1, second.xCount);
+    }
+
+    TEST_CASE("Throwing listener ends the notification")
+    {
+        struct ThrowingListener final : IManyPropertiesListener
+        {
+            void onXChanged() override { throw std::runtime_error("listener"); }
+
+            void onYChanged() override {}
+        } thrower;
+        ClassicSubscription<IManyPropertiesListener> subscription;
+        CountingListener listener;
+        auto throwerDisposable = subscription.subscribe(&thrower);
+        auto disposable = subscription.subscribe(&listener);
+        REQUIRE_THROWS_AS(subscription.notifyAll(&IManyPropertiesListener::onXChanged), std::runtime_error);
+        CHECK_EQ(0, listener.xCount);
+
+        throwerDisposable.dispose();
+        subscription.freeze();
+        REQUIRE(subscription.frozen());
+        subscription.notifyAll(&IManyPropertiesListener::onXChanged);
+        CHECK_EQ(1, listener.xCount);
+    }
+
+    TEST_CASE("Memory resource")
+    {
+        CountingResource resource;
+        {
+            ClassicSubscription<IManyPropertiesListener, CountingListener> subscription(&resource);
+            CountingListener listener;
+            auto disposable = subscription.subscribe(&listener, &IManyPropertiesListener::onXChanged);
+            subscription.notifyAll(&IManyPropertiesListener::onXChanged);
+            CHECK_EQ(1, listener.xCount);
+            REQUIRE_GT(resource.allocations, 0);
+        }
+        REQUIRE_EQ(0, resource.outstanding);
+    }
+
+    TEST_CASE_TEMPLATE("Threading policy", Threading, SingleThreaded, MultiThreaded)
+    {
+        CountingResource resource;
+        CountingListener listener;
+        {
+            Disposable disposable;
+            {
+                BasicClassicSubscription<Threading, IManyPropertiesListener, CountingListener>
+                    subscription(&resource);
+                disposable = subscription.subscribe(&listener);
+                subscription.notifyAll(&IManyPropertiesListener::onYChanged);
+                CHECK_EQ(1, listener.yCount);
+            }
+            // The handle outlives the subscription and keeps its state
+            REQUIRE_GT(resource.outstanding, 0);
+        }
+        REQUIRE_EQ(0, resource.outstanding);
+    }
+
+    TEST_CASE("Unordered subscription")
+    {
+        BasicSubscription<Listeners<IManyPropertiesListener>, SingleThreaded, VectorStorage, Unordered>
+            subscription;
+        CountingListener listeners[3];
+        std::vector<Disposable> disposables;
+        for (auto& listener : listeners)
+            disposables.push_back(subscription.subscribe(&listener));
+        disposables[0].dispose();
+        subscription.notifyAll(&IManyPropertiesListener::onXChanged);
+        CHECK_EQ(0, listeners[0].xCount);
+        CHECK_EQ(1, listeners[1].xCount);
+        CHECK_EQ(1, listeners[2].xCount);
+        REQUIRE_THROWS((void)subscription.subscribe(&listeners[1]));
+        REQUIRE_NOTHROW(disposables.push_back(subscription.subscribe(&listeners[0])));
+    }
+
+    TEST_CASE("Combined results")
+    {
+        ClassicSubscription<IVoter, Voter> subscription;
+        Voter voters[] = {{true, 3}, {false, 1}, {true, 2}};
+
+        SUBCASE("of no listeners") {
+            CHECK(subscription.notifyAll(AllOf(), &IVoter::canRebuild, 1));
+            CHECK_FALSE(subscription.notifyAll(Min<int>(), &IVoter::cost).has_value());
+        }
+
+        std::vector<Disposable> disposables;
+        for (auto& voter : voters)
+            disposables.push_back(subscription.subscribe(&voter));
+
+        SUBCASE("are folded") {
+            CHECK_EQ(6, subscription.notifyAll(Sum<int>(), &IVoter::cost));
+            CHECK_EQ(1, subscription.notifyAll(Min<int>(), &IVoter::cost));
+            CHECK_EQ(3, subscription.notifyAll(Max<int>(), &IVoter::cost));
+        }
+
+        SUBCASE("stop the notification") {
+            CHECK_FALSE(subscription.notifyAll(AllOf(), &IVoter::canRebuild, 1));
+            CHECK_EQ(std::vector<int>{1, 1, 0}, std::vector<int>{voters[0].calls, voters[1].calls, voters[2].calls});
+            CHECK(subscription.notifyAll(AnyOf(), &IVoter::canRebuild, 1));
+            CHECK_EQ(std::vector<int>{2, 1, 0}, std::vector<int>{voters[0].calls, voters[1].calls, voters[2].calls});
+        }
+
+        SUBCASE("skip listeners not interested in the member") {
+            Voter listed(false, 10);
+            disposables.push_back(subscription.subscribe(&listed, &IVoter::cost));
+            CHECK_EQ(16, subscription.notifyAll(Sum<int>(), &IVoter::cost));
+            CHECK_FALSE(subscription.notifyAll(AnyOf(), &IVoter::canRebuild, -1));
+            CHECK_EQ(0, listed.calls);
+        }
+    }
+
+    TEST_CASE("Consumable events")
+    {
+        ClassicSubscription<IKeyHandler> subscription;
+        KeyHandler handlers[] = {KeyHandler(1), KeyHandler(2), KeyHandler(3)};
+        std::vector<Disposable> disposables;
+        for (auto& handler : handlers)
+            disposables.push_back(subscription.subscribe(&handler));
+
+        CHECK(subscription.notifyUntilHandled(&IKeyHandler::onKey, 2));
+        CHECK_EQ(std::vector<int>{1, 1, 0}, std::vector<int>{handlers[0].calls, handlers[1].calls, handlers[2].calls});
+        CHECK_FALSE(subscription.notifyUntilHandled(&IKeyHandler::onKey, 4));
+        CHECK_EQ(std::vector<int>{2, 2, 1}, std::vector<int>{handlers[0].calls, handlers[1].calls, handlers[2].calls});
+    }
+}
@@ -0,0 +1,99 @@
+#include "doctest.h"
+
+#include "subscriptions/BasicSubscription.h"
+
+#include <vector>
+
+using namespace subscriptions;
+
+namespace {
+struct Listener {
+    virtual ~Listener() = default;
+
+    virtual void onChanged() = 0;
+};
+
+struct CountingListener final : Listener {
+    void onChanged() override { ++count; }
+
+    int count = 0;
+};
+}
+
+TEST_SUITE("CompositeDisposable") {
+
+    TEST_CASE("Disposes handles of several subscriptions")
+    {
+        LambdaSubscription lambdas1;
+        LambdaSubscription lambdas2;
+        BasicSubscription<void(int)> arguments;
+        ClassicSubscription<Listener> listeners;
+        int count = 0;
+        CountingListener listener;
+
+        CompositeDisposable disposables;
+        disposables.reserve(32);
+        for (int i = 0; i < 10; ++i) {
+            disposables += lambdas1.subscribe([&count]() { ++count; });
+            disposables += lambdas2.subscribe([&count]() { ++count; }, i % 3);
+        }
+        disposables += arguments.subscribe([&count](int value) { count += value; });
+        disposables += listeners.subscribe(&listener);
+        disposables += Disposable();
+        REQUIRE_EQ(22, disposables.size());
+
+        auto kept = lambdas1.subscribe([&count]() { count += 100; });
+
+        SUBCASE("on destruction") {
+            {
+                CompositeDisposable moved(std::move(disposables));
+            }
+            lambdas1.notifyAll();
+            lambdas2.notifyAll();
+            arguments.notifyAll(1000);
+            listeners.notifyAll(&Listener::onChanged);
+            REQUIRE_EQ(100, count);
+            REQUIRE_EQ(0, listener.count);
+        }
+
+        SUBCASE("of frozen subscription") {
+            lambdas1.freeze();
+            disposables.dispose();
+            REQUIRE_EQ(0, disposables.size());
+            lambdas1.notifyAll();
+            REQUIRE_EQ(100, count);
+        }
+
+        SUBCASE("during notification") {
+            auto disposer = lambdas1.subscribe([&]() { disposables.dispose(); });
+            lambdas1.notifyAll();
+            REQUIRE_EQ(110, count);
+            count = 0;
+            lambdas1.notifyAll();
+            REQUIRE_EQ(100, count);
+        }
+
+        SUBCASE("after the subscription is destroyed") {
+            LambdaSubscription temporary;
+            for (int i = 0; i < 3; ++i)
+                disposables += temporary.subscribe([]() {});
+            temporary = LambdaSubscription();
+            REQUIRE_NOTHROW(disposables.dispose());
+        }
+    }
+
+    TEST_CASE("Skips handles of retired callbacks")
+    {
+        LambdaSubscription subscription;
+        int count = 0;
+        CompositeDisposable disposables;
+        disposables += subscription.subscribeOnce([&count]() { ++count; });
+        disposables += subscription.subscribe([&count]() { ++count; });
+        disposables += subscription.subscribe([&count]() { ++count; });
+        subscription.notifyAll();
+        REQUIRE_EQ(3, count);
+        disposables.dispose();
+        subscription.notifyAll();
+        REQUIRE_EQ(3, count);
+    }
+}
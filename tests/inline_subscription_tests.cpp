@@ -0,0 +1,105 @@
+#include "doctest.h"
+
+#include "subscriptions/InlineSubscription.h"
+
+#include <stdexcept>
+#include <vector>
+
+using namespace subscriptions;
+
+TEST_SUITE("InlineSubscription") {
+
+    TEST_CASE("NotifyAll")
+    {
+        InlineSubscription<2, int> subscription;
+        std::vector<int> calls;
+        auto callback = [&](int value) { calls.push_back(value); };
+
+        SUBCASE("notifyAll does nothing for empty class") {
+            REQUIRE_NOTHROW(subscription.notifyAll(1));
+        }
+
+        SUBCASE("notifyAll passes arguments") {
+            auto disposable = subscription.subscribe(callback);
+            subscription.notifyAll(7);
+            REQUIRE_EQ(std::vector<int>{7}, calls);
+        }
+
+        SUBCASE("callbacks over inline capacity are spilled") {
+            std::vector<Disposable> disposables;
+            for (int i = 0; i < 5; ++i)
+                disposables.push_back(subscription.subscribe([&calls, i](int) { calls.push_back(i); }));
+            subscription.notifyAll(0);
+            REQUIRE_EQ(std::vector<int>{0, 1, 2, 3, 4}, calls);
+
+            SUBCASE("and compacted in order on unsubscription") {
+                calls.clear();
+                disposables[0].dispose();
+                disposables[3].dispose();
+                subscription.notifyAll(0);
+                REQUIRE_EQ(std::vector<int>{1, 2, 4}, calls);
+
+                calls.clear();
+                disposables[4].dispose();
+                subscription.notifyAll(0);
+                REQUIRE_EQ(std::vector<int>{1, 2}, calls);
+            }
+        }
+
+        SUBCASE("unsubscription during a call") {
+            Disposable disposable;
+            auto disposable1 = subscription.subscribe([&](int value) {
+                calls.push_back(value);
+                disposable.dispose();
+            });
+            disposable = subscription.subscribe(callback);
+            subscription.notifyAll(1);
+            subscription.notifyAll(2);
+            REQUIRE_EQ(std::vector<int>{1, 2}, calls);
+        }
+
+        SUBCASE("subscription during a call") {
+            std::vector<Disposable> disposables;
+            disposables.push_back(subscription.subscribe([&](int value) {
+                calls.push_back(value);
+                for (int i = 0; i < 3; ++i)
+                    disposables.push_back(subscription.subscribe(callback));
+            }));
+            subscription.notifyAll(1);
+            REQUIRE_EQ(std::vector<int>{1}, calls);
+            REQUIRE_EQ(4, disposables.size());
+
+            calls.clear();
+            disposables.erase(disposables.begin());
+            subscription.notifyAll(2);
+            REQUIRE_EQ(std::vector<int>{2, 2, 2}, calls);
+        }
+    }
+
+    TEST_CASE("Unsubscribe when subscription has passed away")
+    {
+        Disposable disposable;
+        {
+            InlineSubscription<1> subscription;
+            disposable = subscription.subscribe([]() {});
+        }
+        disposable.dispose();
+    }
+
+    TEST_CASE("Throwing callback ends the notification")
+    {
+        InlineSubscription<2> subscription;
+        int calls = 0;
+        Disposable nested;
+        auto thrower = subscription.subscribe([&]() {
+            nested = subscription.subscribe([&calls]() { ++calls; });
+            throw std::runtime_error("callback");
+        });
+        REQUIRE_THROWS_AS(subscription.notifyAll(), std::runtime_error);
+        thrower.dispose();
+
+        auto late = subscription.subscribe([&calls]() { calls += 10; });
+        subscription.notifyAll();
+        REQUIRE_EQ(11, calls);
+    }
+}
@@ -0,0 +1,123 @@
+#include "doctest.h"
+
+#include "subscriptions/IntrusiveSubscription.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+using namespace subscriptions;
+
+namespace {
+struct Listener {
+    void onChanged()
+    {
+        ++count;
+        if (action)
+            action();
+    }
+
+    int count = 0;
+    std::function<void()> action;
+    SubscriptionHook hook;
+};
+}
+
+TEST_SUITE("IntrusiveSubscription") {
+
+    TEST_CASE("NotifyAll")
+    {
+        IntrusiveSubscription subscription;
+        std::vector<Listener> listeners(3);
+        for (auto& listener : listeners)
+            subscription.subscribe<&Listener::onChanged>(listener.hook, &listener);
+
+        SUBCASE("notifyAll calls all listeners") {
+            subscription.notifyAll();
+            for (auto& listener : listeners)
+                CHECK_EQ(1, listener.count);
+        }
+
+        SUBCASE("unlinked listener is not called") {
+            listeners[1].hook.unlink();
+            REQUIRE_FALSE(listeners[1].hook.linked());
+            subscription.notifyAll();
+            CHECK_EQ(1, listeners[0].count);
+            CHECK_EQ(0, listeners[1].count);
+            CHECK_EQ(1, listeners[2].count);
+        }
+
+        SUBCASE("listener unlinks oneself during a call") {
+            listeners[1].action = [&]() { listeners[1].hook.unlink(); };
+            subscription.notifyAll();
+            subscription.notifyAll();
+            CHECK_EQ(2, listeners[0].count);
+            CHECK_EQ(1, listeners[1].count);
+            CHECK_EQ(2, listeners[2].count);
+        }
+
+        SUBCASE("listener unlinks the next one during a call") {
+            listeners[0].action = [&]() { listeners[1].hook.unlink(); };
+            subscription.notifyAll();
+            CHECK_EQ(1, listeners[0].count);
+            CHECK_EQ(0, listeners[1].count);
+            CHECK_EQ(1, listeners[2].count);
+        }
+
+        SUBCASE("listener linked during a call is notified next time") {
+            Listener added;
+            listeners[0].action = [&]() {
+                if (!added.hook.linked())
+                    subscription.subscribe<&Listener::onChanged>(added.hook, &added);
+            };
+            subscription.notifyAll();
+            CHECK_EQ(0, added.count);
+            subscription.notifyAll();
+            CHECK_EQ(1, added.count);
+        }
+
+        SUBCASE("nested notification") {
+            listeners[0].action = [&]() {
+                listeners[0].action = nullptr;
+                listeners[1].hook.unlink();
+                subscription.notifyAll();
+            };
+            subscription.notifyAll();
+            CHECK_EQ(2, listeners[0].count);
+            CHECK_EQ(0, listeners[1].count);
+            CHECK_EQ(2, listeners[2].count);
+        }
+    }
+
+    TEST_CASE("Lifetime")
+    {
+        SUBCASE("destroyed hook is unlinked") {
+            IntrusiveSubscription subscription;
+            auto listener = std::make_unique<Listener>();
+            subscription.subscribe<&Listener::onChanged>(listener->hook, listener.get());
+            listener.reset();
+            subscription.notifyAll();
+        }
+
+        SUBCASE("hook outlives subscription") {
+            Listener listener;
+            {
+                IntrusiveSubscription subscription;
+                subscription.subscribe<&Listener::onChanged>(listener.hook, &listener);
+            }
+            REQUIRE_FALSE(listener.hook.linked());
+        }
+
+        SUBCASE("hook moves to another subscription") {
+            IntrusiveSubscription first;
+            IntrusiveSubscription second;
+            Listener listener;
+            first.subscribe<&Listener::onChanged>(listener.hook, &listener);
+            second.subscribe<&Listener::onChanged>(listener.hook, &listener);
+            first.notifyAll();
+            CHECK_EQ(0, listener.count);
+            second.notifyAll();
+            CHECK_EQ(1, listener.count);
+        }
+    }
+}
@@ -1,8 +1,36 @@
 #include "doctest.h"
 
 #include "subscriptions/LambdaSubscription.h"
+
+#include "counting_resource.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
 using namespace subscriptions;
 
+namespace {
+struct Counter {
+    void increment() { ++count; }
+
+    int count = 0;
+};
+
+struct TrackableCounter : Trackable {
+    void increment() { ++count; }
+
+    int count = 0;
+};
+}
+
 TEST_SUITE("LambdaSubscription") {
 
     TEST_CASE ("Constructor")
@@ -151,4 +179,717 @@ TEST_SUITE("LambdaSubscription") {
             REQUIRE_EQ(expectedCount + addedCount, disposable.size());
         }
     }
-}
\ No newline at end of file
+
+    TEST_CASE("Member function subscription")
+    {
+        LambdaSubscription subscription;
+        Counter counter;
+        auto disposable = subscription.subscribe<&Counter::increment>(&counter);
+
+        SUBCASE("Member function is called") {
+            subscription.notifyAll();
+            REQUIRE_EQ(1, counter.count);
+        }
+
+        SUBCASE("Member function is not called after unsubscription") {
+            disposable.dispose();
+            subscription.notifyAll();
+            REQUIRE_EQ(0, counter.count);
+        }
+    }
+
+    TEST_CASE("Member function resubscription does not allocate")
+    {
+        CountingResource resource;
+        {
+            LambdaSubscription subscription(&resource);
+            Counter counter;
+            std::vector<Disposable> disposables;
+            auto subscribeAll = [&]() {
+                for (int i = 0; i < 8; ++i)
+                    disposables.push_back(subscription.subscribe<&Counter::increment>(&counter));
+            };
+            disposables.reserve(8);
+            subscribeAll();
+            disposables.clear();
+            const auto allocations = resource.allocations;
+            for (int round = 0; round < 10; ++round) {
+                subscribeAll();
+                subscription.notifyAll();
+                disposables.clear();
+            }
+            REQUIRE_EQ(allocations, resource.allocations);
+            REQUIRE_EQ(80, counter.count);
+        }
+        REQUIRE_EQ(0, resource.outstanding);
+    }
+
+    TEST_CASE("Callback lifetime")
+    {
+        LambdaSubscription subscription;
+        auto resource = std::make_shared<int>(0);
+
+        SUBCASE("Callback kept in place is destroyed on unsubscription") {
+            auto disposable = subscription.subscribe([resource]() { ++*resource; });
+            subscription.notifyAll();
+            REQUIRE_EQ(1, *resource);
+            disposable.dispose();
+            REQUIRE_EQ(1, resource.use_count());
+        }
+
+        SUBCASE("Callback with large capture is destroyed on unsubscription") {
+            std::array<int, 16> payload{};
+            auto disposable = subscription.subscribe([resource, payload]() { *resource += payload[0] + 1; });
+            subscription.notifyAll();
+            REQUIRE_EQ(1, *resource);
+            disposable.dispose();
+            REQUIRE_EQ(1, resource.use_count());
+        }
+
+        SUBCASE("Callback released during a call is destroyed after notification") {
+            Disposable disposable;
+            disposable = subscription.subscribe([resource, &disposable]() {
+                disposable.dispose();
+                ++*resource;
+            });
+            subscription.notifyAll();
+            REQUIRE_EQ(1, *resource);
+            REQUIRE_EQ(1, resource.use_count());
+        }
+    }
+
+    TEST_CASE("Weak pointer subscription")
+    {
+        LambdaSubscription subscription;
+        auto counter = std::make_shared<Counter>();
+        auto disposable = subscription.subscribe<&Counter::increment>(std::weak_ptr<Counter>(counter));
+
+        SUBCASE("Member function is called while the observer is alive") {
+            subscription.notifyAll();
+            REQUIRE_EQ(1, counter->count);
+        }
+
+        SUBCASE("Expired observer is removed during notification") {
+            // The control block is freed when the callback releases its weak pointer
+            CountingResource observerMemory;
+            auto observer = std::allocate_shared<Counter>(
+                std::pmr::polymorphic_allocator<Counter>(&observerMemory));
+            auto observerDisposable =
+                subscription.subscribe<&Counter::increment>(std::weak_ptr<Counter>(observer));
+            observer.reset();
+            REQUIRE_GT(observerMemory.outstanding, 0);
+            subscription.notifyAll();
+            REQUIRE_EQ(0, observerMemory.outstanding);
+            REQUIRE_EQ(1, counter->count);
+            observerDisposable.dispose();
+        }
+    }
+
+    TEST_CASE("Growing from and shrinking to one subscriber")
+    {
+        LambdaSubscription subscription;
+        std::vector<int> calls;
+        auto disposable1 = subscription.subscribe([&]() { calls.push_back(1); });
+        subscription.notifyAll();
+        auto disposable2 = subscription.subscribe([&]() { calls.push_back(2); });
+        subscription.notifyAll();
+        REQUIRE_EQ(std::vector<int>{1, 1, 2}, calls);
+
+        SUBCASE("the first is unsubscribed") {
+            calls.clear();
+            disposable1.dispose();
+            subscription.notifyAll();
+            auto disposable3 = subscription.subscribe([&]() { calls.push_back(3); });
+            subscription.notifyAll();
+            REQUIRE_EQ(std::vector<int>{2, 2, 3}, calls);
+        }
+
+        SUBCASE("the last is unsubscribed during a call") {
+            calls.clear();
+            auto disposable3 = subscription.subscribe([&]() {
+                calls.push_back(3);
+                disposable2.dispose();
+                disposable1.dispose();
+            });
+            subscription.notifyAll();
+            subscription.notifyAll();
+            REQUIRE_EQ(std::vector<int>{1, 2, 3, 3}, calls);
+        }
+    }
+
+    TEST_CASE("Frozen subscription")
+    {
+        LambdaSubscription subscription;
+        std::vector<int> calls;
+        std::vector<Disposable> disposables;
+        for (int i = 0; i < 3; ++i)
+            disposables.push_back(subscription.subscribe([&calls, i]() { calls.push_back(i); }));
+        subscription.freeze();
+        REQUIRE(subscription.frozen());
+
+        SUBCASE("notifies in subscription order") {
+            subscription.notifyAll();
+            REQUIRE_EQ(std::vector<int>{0, 1, 2}, calls);
+        }
+
+        SUBCASE("subscription thaws it") {
+            disposables.push_back(subscription.subscribe([&]() { calls.push_back(3); }));
+            REQUIRE_FALSE(subscription.frozen());
+            subscription.notifyAll();
+            REQUIRE_EQ(std::vector<int>{0, 1, 2, 3}, calls);
+        }
+
+        SUBCASE("unsubscription thaws it") {
+            disposables[1].dispose();
+            REQUIRE_FALSE(subscription.frozen());
+            subscription.notifyAll();
+            REQUIRE_EQ(std::vector<int>{0, 2}, calls);
+        }
+
+        SUBCASE("unsubscription during notification") {
+            disposables.push_back(subscription.subscribe([&]() {
+                calls.push_back(3);
+                disposables[3].dispose();
+                disposables[0].dispose();
+            }));
+            disposables.push_back(subscription.subscribe([&]() { calls.push_back(4); }));
+            subscription.freeze();
+            subscription.notifyAll();
+            REQUIRE_EQ(std::vector<int>{0, 1, 2, 3, 4}, calls);
+            REQUIRE_FALSE(subscription.frozen());
+
+            calls.clear();
+            subscription.notifyAll();
+            REQUIRE_EQ(std::vector<int>{1, 2, 4}, calls);
+        }
+
+        SUBCASE("unsubscription of a later callback during notification") {
+            disposables.push_back(subscription.subscribe([&]() { disposables[4].dispose(); }));
+            disposables.push_back(subscription.subscribe([&]() { calls.push_back(4); }));
+            subscription.freeze();
+            subscription.notifyAll();
+            REQUIRE_EQ(std::vector<int>{0, 1, 2}, calls);
+        }
+    }
+
+    TEST_CASE("Callbacks with large captures")
+    {
+        LambdaSubscription subscription;
+        auto resource = std::make_shared<int>(0);
+        std::vector<Disposable> disposables;
+        for (int i = 0; i < 100; ++i) {
+            std::array<int, 16> payload{};
+            payload.back() = i;
+            disposables.push_back(subscription.subscribe([resource, payload]() { *resource += payload.back(); }));
+        }
+
+        SUBCASE("are relocated when half of them is released") {
+            for (size_t i = 0; i < disposables.size(); i += 2)
+                disposables[i].dispose();
+            subscription.notifyAll();
+            REQUIRE_EQ(2500, *resource);
+            REQUIRE_EQ(51, resource.use_count());
+            subscription.notifyAll();
+            REQUIRE_EQ(5000, *resource);
+        }
+
+        SUBCASE("are relocated by freeze") {
+            disposables.front().dispose();
+            subscription.freeze();
+            subscription.notifyAll();
+            REQUIRE_EQ(4950, *resource);
+            disposables.clear();
+            REQUIRE_EQ(1, resource.use_count());
+        }
+    }
+
+    TEST_CASE("Memory resource")
+    {
+        CountingResource resource;
+        {
+            LambdaSubscription subscription(&resource);
+            REQUIRE_EQ(0, resource.allocations);
+
+            std::array<int, 16> payload{};
+            int sum = 0;
+            auto disposable1 = subscription.subscribe([&sum]() { ++sum; });
+            auto disposable2 = subscription.subscribe([&sum, payload]() { sum += payload[0] + 1; });
+            subscription.freeze();
+            subscription.notifyAll();
+            REQUIRE_EQ(2, sum);
+            REQUIRE_GT(resource.allocations, 0);
+            disposable1.dispose();
+        }
+        REQUIRE_EQ(0, resource.outstanding);
+    }
+
+    TEST_CASE("Priorities")
+    {
+        LambdaSubscription subscription;
+        std::vector<int> calls;
+        auto record = [&calls](int value) { return [&calls, value]() { calls.push_back(value); }; };
+        std::vector<Disposable> disposables;
+        disposables.push_back(subscription.subscribe(record(1)));
+        disposables.push_back(subscription.subscribe(record(2), -1));
+        disposables.push_back(subscription.subscribe(record(3), 10));
+        disposables.push_back(subscription.subscribe(record(4)));
+        disposables.push_back(subscription.subscribe(record(5), 10));
+        subscription.notifyAll();
+        REQUIRE_EQ(std::vector<int>{3, 5, 1, 4, 2}, calls);
+
+        SUBCASE("resubscription keeps the place given by priority") {
+            calls.clear();
+            disposables[2].dispose();
+            disposables[2] = subscription.subscribe(record(3), 10);
+            subscription.notifyAll();
+            REQUIRE_EQ(std::vector<int>{5, 3, 1, 4, 2}, calls);
+        }
+
+        SUBCASE("subscription during notification") {
+            disposables.push_back(subscription.subscribe([&]() {
+                if (disposables.size() == 6)
+                    disposables.push_back(subscription.subscribe(record(6), 100));
+            }));
+            subscription.notifyAll();
+            calls.clear();
+            subscription.notifyAll();
+            REQUIRE_EQ(std::vector<int>{6, 3, 5, 1, 4, 2}, calls);
+        }
+
+        SUBCASE("are kept by freeze") {
+            subscription.freeze();
+            disposables.push_back(subscription.subscribe(record(6), 5));
+            calls.clear();
+            subscription.notifyAll();
+            REQUIRE_EQ(std::vector<int>{3, 5, 6, 1, 4, 2}, calls);
+        }
+
+        SUBCASE("of the last callback") {
+            disposables.erase(disposables.begin() + 1, disposables.end());
+            disposables.push_back(subscription.subscribe(record(7), 1));
+            calls.clear();
+            subscription.notifyAll();
+            REQUIRE_EQ(std::vector<int>{7, 1}, calls);
+        }
+    }
+
+    TEST_CASE("Limited subscriptions")
+    {
+        LambdaSubscription subscription;
+        int once = 0;
+        int thrice = 0;
+        int always = 0;
+        auto disposable1 = subscription.subscribeOnce([&once]() { ++once; });
+        auto disposable2 = subscription.subscribeN(3, [&thrice]() { ++thrice; });
+        auto disposable3 = subscription.subscribe([&always]() { ++always; });
+
+        SUBCASE("retire after their calls") {
+            for (int i = 0; i < 5; ++i)
+                subscription.notifyAll();
+            REQUIRE_EQ(1, once);
+            REQUIRE_EQ(3, thrice);
+            REQUIRE_EQ(5, always);
+            REQUIRE_NOTHROW(disposable2.dispose());
+        }
+
+        SUBCASE("retire once in nested notification of frozen subscription") {
+            LambdaSubscription frozen;
+            int calls = 0;
+            bool nested = false;
+            auto renotifier = frozen.subscribe([&]() {
+                if (!std::exchange(nested, true))
+                    frozen.notifyAll();
+            });
+            auto once = frozen.subscribeOnce([&calls]() { ++calls; });
+            auto future = frozen.nextNotification();
+            frozen.freeze();
+            REQUIRE_NOTHROW(frozen.notifyAll());
+            REQUIRE_EQ(1, calls);
+            REQUIRE_EQ(std::future_status::ready, future.wait_for(std::chrono::seconds(0)));
+            frozen.notifyAll();
+            REQUIRE_EQ(1, calls);
+        }
+
+        SUBCASE("are not called again from nested notification") {
+            LambdaSubscription renotified;
+            int calls = 0;
+            int twice = 0;
+            auto once = renotified.subscribeOnce([&]() {
+                if (++calls < 3)
+                    renotified.notifyAll();
+            });
+            auto limited = renotified.subscribeN(2, [&]() {
+                if (++twice < 5)
+                    renotified.notifyAll();
+            });
+            renotified.notifyAll();
+            REQUIRE_EQ(1, calls);
+            REQUIRE_EQ(2, twice);
+            renotified.notifyAll();
+            REQUIRE_EQ(1, calls);
+            REQUIRE_EQ(2, twice);
+        }
+
+        SUBCASE("can be disposed before") {
+            subscription.notifyAll();
+            disposable2.dispose();
+            subscription.notifyAll();
+            REQUIRE_EQ(1, thrice);
+        }
+
+        SUBCASE("with no calls are not subscribed") {
+            auto disposable = subscription.subscribeN(0, [&once]() { ++once; });
+            disposable1.dispose();
+            subscription.notifyAll();
+            REQUIRE_EQ(0, once);
+        }
+    }
+
+    TEST_CASE("Callbacks returning bool")
+    {
+        LambdaSubscription subscription;
+        std::vector<int> calls;
+        auto until = [&calls](int value, int last) {
+            return [&calls, value, last]() {
+                calls.push_back(value);
+                return value != last || calls.size() < 3;
+            };
+        };
+        auto disposable1 = subscription.subscribe(until(1, 1));
+        auto disposable2 = subscription.subscribe(until(2, 0));
+
+        SUBCASE("are removed after returning false") {
+            for (int i = 0; i < 3; ++i)
+                subscription.notifyAll();
+            REQUIRE_EQ(std::vector<int>{1, 2, 1, 2, 2}, calls);
+            REQUIRE_NOTHROW(disposable1.dispose());
+            subscription.notifyAll();
+            REQUIRE_EQ(std::vector<int>{1, 2, 1, 2, 2, 2}, calls);
+        }
+
+        SUBCASE("are removed from frozen subscription") {
+            subscription.freeze();
+            for (int i = 0; i < 3; ++i)
+                subscription.notifyAll();
+            REQUIRE_EQ(std::vector<int>{1, 2, 1, 2, 2}, calls);
+            disposable1.dispose();
+            disposable2.dispose();
+            subscription.notifyAll();
+            REQUIRE_EQ(5, calls.size());
+        }
+
+        SUBCASE("are removed when single") {
+            disposable2.dispose();
+            for (int i = 0; i < 4; ++i)
+                subscription.notifyAll();
+            REQUIRE_EQ(std::vector<int>{1, 1, 1}, calls);
+            disposable1.dispose();
+        }
+    }
+
+    TEST_CASE("Next notification")
+    {
+        std::future<void> future;
+        {
+            LambdaSubscription subscription;
+            future = subscription.nextNotification();
+            REQUIRE_EQ(std::future_status::timeout, future.wait_for(std::chrono::seconds(0)));
+            subscription.notifyAll();
+            REQUIRE_EQ(std::future_status::ready, future.wait_for(std::chrono::seconds(0)));
+            REQUIRE_NOTHROW(future.get());
+
+            future = subscription.nextNotification();
+        }
+        REQUIRE_THROWS_AS(future.get(), std::future_error);
+    }
+
+    TEST_CASE("Bulk subscription")
+    {
+        CountingResource resource;
+        std::vector<int> calls;
+        std::vector<std::function<void()>> callbacks;
+        for (int i = 0; i < 4; ++i)
+            callbacks.push_back([&calls, i]() { calls.push_back(i); });
+        {
+            std::vector<Disposable> disposables;
+            std::vector<Disposable> outliving;
+            {
+                LambdaSubscription subscription(&resource);
+                auto first = subscription.subscribe([&calls]() { calls.push_back(10); }, 1);
+                disposables = subscription.subscribeMany(callbacks);
+                REQUIRE_EQ(4, disposables.size());
+                REQUIRE_EQ(4, callbacks.size());
+                REQUIRE(callbacks.front());
+
+                SUBCASE("keeps order and priority") {
+                    auto last = subscription.subscribeMany(std::move(callbacks), 2);
+                    subscription.notifyAll();
+                    REQUIRE_EQ(std::vector<int>{0, 1, 2, 3, 10, 0, 1, 2, 3}, calls);
+                }
+
+                SUBCASE("handles are disposed separately") {
+                    disposables[1].dispose();
+                    disposables[3].dispose();
+                    subscription.notifyAll();
+                    REQUIRE_EQ(std::vector<int>{10, 0, 2}, calls);
+                }
+
+                SUBCASE("handles are disposed together") {
+                    disposeMany(disposables);
+                    subscription.notifyAll();
+                    REQUIRE_EQ(std::vector<int>{10}, calls);
+                }
+
+                SUBCASE("during notification") {
+                    std::vector<Disposable> added;
+                    auto adder = subscription.subscribe([&]() {
+                        if (added.empty())
+                            added = subscription.subscribeMany(callbacks, -1);
+                    }, -1);
+                    subscription.notifyAll();
+                    REQUIRE_EQ(std::vector<int>{10, 0, 1, 2, 3}, calls);
+                    calls.clear();
+                    subscription.notifyAll();
+                    REQUIRE_EQ(std::vector<int>{10, 0, 1, 2, 3, 0, 1, 2, 3}, calls);
+                }
+
+                SUBCASE("of empty range") {
+                    REQUIRE(subscription.subscribeMany(std::vector<std::function<void()>>()).empty());
+                }
+                outliving = subscription.subscribeMany(callbacks);
+            }
+            // Handles allocated together outlive the subscription
+            REQUIRE_GT(resource.outstanding, 0);
+        }
+        REQUIRE_EQ(0, resource.outstanding);
+    }
+
+    TEST_CASE("Consumable events")
+    {
+        LambdaSubscription subscription;
+        std::vector<int> calls;
+        auto handler = [&calls](int index, Propagation propagation) {
+            return [&calls, index, propagation]() {
+                calls.push_back(index);
+                return propagation;
+            };
+        };
+        auto disposable1 = subscription.subscribe(handler(1, Propagation::Continue), 1);
+        auto disposable2 = subscription.subscribe(handler(2, Propagation::Stop));
+        auto disposable3 = subscription.subscribe(handler(3, Propagation::Continue));
+
+        SUBCASE("stop at the handling callback") {
+            REQUIRE(subscription.notifyUntilHandled());
+            REQUIRE_EQ(std::vector<int>{1, 2}, calls);
+        }
+
+        SUBCASE("are not handled without a stopping callback") {
+            disposable2.dispose();
+            REQUIRE_FALSE(subscription.notifyUntilHandled());
+            REQUIRE_EQ(std::vector<int>{1, 3}, calls);
+        }
+
+        SUBCASE("are not stopped by notifyAll") {
+            subscription.notifyAll();
+            REQUIRE_EQ(std::vector<int>{1, 2, 3}, calls);
+        }
+
+        SUBCASE("stop frozen subscription") {
+            subscription.freeze();
+            REQUIRE(subscription.notifyUntilHandled());
+            REQUIRE_EQ(std::vector<int>{1, 2}, calls);
+        }
+
+        SUBCASE("stop at a member function") {
+            struct Consumer {
+                Propagation consume()
+                {
+                    ++count;
+                    return Propagation::Stop;
+                }
+
+                int count = 0;
+            } consumer;
+            auto consumerDisposable = subscription.subscribe<&Consumer::consume>(&consumer, 2);
+            REQUIRE(subscription.notifyUntilHandled());
+            REQUIRE_EQ(1, consumer.count);
+            REQUIRE(calls.empty());
+
+            SUBCASE("of a weak observer") {
+                consumerDisposable.dispose();
+                auto observer = std::make_shared<Consumer>();
+                auto observerDisposable =
+                    subscription.subscribe<&Consumer::consume>(std::weak_ptr<Consumer>(observer), 2);
+                REQUIRE(subscription.notifyUntilHandled());
+                REQUIRE_EQ(1, observer->count);
+                REQUIRE(calls.empty());
+            }
+        }
+
+        SUBCASE("stop at a limited callback") {
+            auto once = subscription.subscribeOnce(handler(0, Propagation::Stop), 2);
+            REQUIRE(subscription.notifyUntilHandled());
+            REQUIRE_EQ(std::vector<int>{0}, calls);
+            REQUIRE(subscription.notifyUntilHandled());
+            REQUIRE_EQ(std::vector<int>{0, 1, 2}, calls);
+        }
+
+        SUBCASE("of nested notification do not stop the outer one") {
+            LambdaSubscription inner;
+            auto innerDisposable = inner.subscribe(handler(10, Propagation::Stop));
+            auto nested = subscription.subscribe([&]() { inner.notifyAll(); }, 1);
+            disposable2.dispose();
+            REQUIRE_FALSE(subscription.notifyUntilHandled());
+            REQUIRE_EQ(std::vector<int>{1, 10, 3}, calls);
+        }
+    }
+
+    TEST_CASE("Throwing callback")
+    {
+        LambdaSubscription subscription;
+        int calls = 0;
+        Disposable nested;
+        auto thrower = subscription.subscribe([&]() {
+            nested = subscription.subscribe([&calls]() { ++calls; });
+            throw std::runtime_error("callback");
+        });
+        REQUIRE_THROWS_AS(subscription.notifyAll(), std::runtime_error);
+        thrower.dispose();
+
+        SUBCASE("ends the notification") {
+            auto late = subscription.subscribe([&calls]() { calls += 10; });
+            subscription.notifyAll();
+            subscription.notifyAll();
+            REQUIRE_EQ(22, calls);
+        }
+
+        SUBCASE("does not leave the notification handled") {
+            auto handler = subscription.subscribe([]() { return Propagation::Continue; });
+            REQUIRE_FALSE(subscription.notifyUntilHandled());
+        }
+
+        SUBCASE("does not prevent freezing") {
+            subscription.freeze();
+            REQUIRE(subscription.frozen());
+            subscription.notifyAll();
+            REQUIRE_EQ(1, calls);
+        }
+    }
+
+    TEST_CASE("Trackable objects")
+    {
+        CountingResource resource;
+        {
+            auto subscription = std::make_unique<LambdaSubscription>(&resource);
+            auto counter = std::make_unique<TrackableCounter>();
+            Counter other;
+            auto otherDisposable = subscription->subscribe<&Counter::increment>(&other);
+            subscription->subscribe<&TrackableCounter::increment>(*counter);
+            subscription->subscribe<&TrackableCounter::increment>(*counter, 1);
+            subscription->notifyAll();
+            REQUIRE_EQ(2, counter->count);
+
+            SUBCASE("are disconnected on destruction") {
+                counter.reset();
+                subscription->notifyAll();
+                REQUIRE_EQ(2, other.count);
+            }
+
+            SUBCASE("are removed by the next notification") {
+                const auto connected = resource.outstanding;
+                counter->disconnectAll();
+                REQUIRE_EQ(connected, resource.outstanding);
+                subscription->notifyAll();
+                REQUIRE_LT(resource.outstanding, connected);
+            }
+
+            SUBCASE("may destroy the object from its member") {
+                struct SelfDestroying : Trackable {
+                    void destroy() { owner->reset(); }
+
+                    std::unique_ptr<SelfDestroying>* owner = nullptr;
+                };
+                auto destroying = std::make_unique<SelfDestroying>();
+                destroying->owner = &destroying;
+                subscription->subscribe<&SelfDestroying::destroy>(*destroying);
+                subscription->notifyAll();
+                REQUIRE_FALSE(destroying);
+                subscription->notifyAll();
+                REQUIRE_EQ(6, counter->count);
+            }
+
+            SUBCASE("are disconnected on request") {
+                counter->disconnectAll();
+                subscription->notifyAll();
+                REQUIRE_EQ(2, counter->count);
+                REQUIRE_EQ(2, other.count);
+            }
+
+            SUBCASE("are disconnected during notification") {
+                auto destroyer = subscription->subscribe([&counter]() { counter.reset(); }, 2);
+                subscription->notifyAll();
+                REQUIRE_FALSE(counter);
+                REQUIRE_EQ(2, other.count);
+            }
+
+            SUBCASE("copies are not connected") {
+                TrackableCounter copy(*counter);
+                subscription->notifyAll();
+                REQUIRE_EQ(4, counter->count);
+                REQUIRE_EQ(2, copy.count);
+            }
+
+            SUBCASE("outlive the subscription") {
+                subscription.reset();
+                REQUIRE_GT(resource.outstanding, 0);
+            }
+        }
+        REQUIRE_EQ(0, resource.outstanding);
+    }
+
+    TEST_CASE_TEMPLATE("Threading policy", Threading, SingleThreaded, MultiThreaded)
+    {
+        CountingResource resource;
+        Counter counter;
+        {
+            Disposable disposable;
+            {
+                BasicLambdaSubscription<Threading> subscription(&resource);
+                disposable = subscription.template subscribe<&Counter::increment>(&counter);
+
+                BasicLambdaSubscription<Threading> moved(std::move(subscription));
+                subscription.notifyAll();
+                moved.notifyAll();
+                REQUIRE_EQ(1, counter.count);
+            }
+            // The handle outlives the subscription and keeps its state
+            REQUIRE_GT(resource.outstanding, 0);
+            disposable.dispose();
+        }
+        REQUIRE_EQ(0, resource.outstanding);
+    }
+
+    TEST_CASE("MultiThreaded subscription from several threads")
+    {
+        BasicLambdaSubscription<MultiThreaded> subscription;
+        std::atomic<int> count{0};
+        auto keeper = subscription.subscribe([&count]() { ++count; });
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&subscription, &count]() {
+                for (int i = 0; i < 1000; ++i) {
+                    auto disposable = subscription.subscribe([&count]() { ++count; });
+                    subscription.notifyAll();
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        const int notified = count;
+        REQUIRE_GE(notified, 4000);
+        subscription.notifyAll();
+        REQUIRE_EQ(notified + 1, count);
+    }
+}
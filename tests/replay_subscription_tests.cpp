@@ -0,0 +1,115 @@
+#include "doctest.h"
+
+#include "subscriptions/ReplaySubscription.h"
+
+#include "counting_resource.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace subscriptions;
+
+namespace {
+struct ManualClock {
+    using duration = std::chrono::milliseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<ManualClock>;
+    static constexpr bool is_steady = true;
+
+    static time_point now() { return current; }
+
+    static inline time_point current{};
+};
+
+using Event = std::pair<int, std::string>;
+}
+
+TEST_SUITE("ReplaySubscription") {
+
+    TEST_CASE("Replays last events on subscription")
+    {
+        ReplaySubscription<int, const std::string&> subscription(3);
+        std::vector<Event> received;
+        auto callback = [&received](int id, const std::string& name) { received.emplace_back(id, name); };
+
+        SUBCASE("nothing before the first notification") {
+            auto disposable = subscription.subscribe(callback);
+            REQUIRE(received.empty());
+            subscription.notifyAll(1, "a");
+            REQUIRE_EQ(std::vector<Event>{{1, "a"}}, received);
+        }
+
+        SUBCASE("events kept before the ring is full") {
+            subscription.notifyAll(1, "a");
+            subscription.notifyAll(2, "b");
+            auto disposable = subscription.subscribe(callback);
+            REQUIRE_EQ(std::vector<Event>{{1, "a"}, {2, "b"}}, received);
+        }
+
+        SUBCASE("last events from the oldest one") {
+            for (int i = 1; i <= 5; ++i)
+                subscription.notifyAll(i, std::to_string(i));
+            auto disposable = subscription.subscribe(callback);
+            REQUIRE_EQ(std::vector<Event>{{3, "3"}, {4, "4"}, {5, "5"}}, received);
+
+            SUBCASE("and then new events") {
+                received.clear();
+                subscription.notifyAll(6, "6");
+                REQUIRE_EQ(std::vector<Event>{{6, "6"}}, received);
+            }
+        }
+
+        SUBCASE("callback asking for removal stops the replay") {
+            for (int i = 1; i <= 3; ++i)
+                subscription.notifyAll(i, std::to_string(i));
+            auto disposable = subscription.subscribe([&received](int id, const std::string& name) {
+                received.emplace_back(id, name);
+                return id < 2 ? Retention::Keep : Retention::Drop;
+            });
+            subscription.notifyAll(4, "4");
+            REQUIRE_EQ(std::vector<Event>{{1, "1"}, {2, "2"}}, received);
+        }
+    }
+
+    TEST_CASE("Replays events within the window")
+    {
+        BasicReplaySubscription<SingleThreaded, ManualClock, int> subscription(
+            10, std::chrono::milliseconds(100));
+        std::vector<int> received;
+        for (int i = 0; i < 5; ++i) {
+            subscription.notifyAll(i);
+            ManualClock::current += std::chrono::milliseconds(40);
+        }
+        auto disposable = subscription.subscribe([&received](int value) { received.push_back(value); });
+        REQUIRE_EQ(std::vector<int>{3, 4}, received);
+    }
+
+    TEST_CASE("Zero capacity is not allowed")
+    {
+        REQUIRE_THROWS_AS((ReplaySubscription<int>(0)), std::invalid_argument);
+    }
+
+    TEST_CASE("Notification allocates no slots")
+    {
+        CountingResource resource;
+        {
+            ReplaySubscription<int> subscription(4, ReplaySubscription<int>::Duration::max(), &resource);
+            int sum = 0;
+            auto disposable = subscription.subscribe([&sum](int value) { sum += value; });
+            const auto allocations = resource.allocations;
+            for (int i = 1; i <= 10; ++i)
+                subscription.notifyAll(i);
+            REQUIRE_EQ(allocations, resource.allocations);
+            REQUIRE_EQ(55, sum);
+
+            int replayed = 0;
+            auto late = subscription.subscribe([&replayed](int value) { replayed += value; });
+            REQUIRE_EQ(7 + 8 + 9 + 10, replayed);
+        }
+        REQUIRE_EQ(0, resource.outstanding);
+    }
+}
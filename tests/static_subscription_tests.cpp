@@ -0,0 +1,39 @@
+#include "doctest.h"
+
+#include "subscriptions/StaticSubscription.h"
+
+#include <vector>
+
+using namespace subscriptions;
+
+TEST_SUITE("StaticSubscription") {
+
+    TEST_CASE("Empty subscription")
+    {
+        StaticSubscription<> subscription;
+        REQUIRE_NOTHROW(subscription.notifyAll());
+    }
+
+    TEST_CASE("NotifyAll")
+    {
+        std::vector<int> calls;
+        StaticSubscription subscription(
+            [&]() { calls.push_back(1); },
+            [&]() { calls.push_back(2); });
+
+        SUBCASE("callbacks are called in order") {
+            subscription.notifyAll();
+            REQUIRE_EQ(std::vector<int>{1, 2}, calls);
+        }
+    }
+
+    TEST_CASE("NotifyAll with arguments")
+    {
+        int sum = 0;
+        StaticSubscription subscription(
+            [&](int value) { sum += value; },
+            [&](int value) { sum += 10 * value; });
+        subscription.notifyAll(2);
+        REQUIRE_EQ(22, sum);
+    }
+}